@@ -0,0 +1,160 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Binary_IO.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Binary_IO_hpp
+#define Binary_IO_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Binary files of the package
+// - Header: magic (8 bytes), format version (uint32), byte order mark (uint32)
+// - All integers are stored as uint64 and all reals as double, in the byte order of the writer
+//   (files are rejected by readers with a different byte order)
+const std::uint32_t binary_version = 1;
+const std::uint32_t binary_byte_order = 0x01020304;
+const char ensemble_magic[8] = {'R', 'S', 'S', 'R', 'E', 'N', 'S', '\0'};
+const char checkpoint_magic[8] = {'R', 'S', 'S', 'R', 'C', 'K', 'P', '\0'};
+
+// Functions to write values
+inline void Write_Header(std::ostream& out, const char* magic) {
+  out.write(magic, 8);
+  out.write(reinterpret_cast<const char*>(&binary_version), sizeof(std::uint32_t));
+  out.write(reinterpret_cast<const char*>(&binary_byte_order), sizeof(std::uint32_t));
+}
+inline void Write_Integer(std::ostream& out, std::uint64_t value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(std::uint64_t));
+}
+inline void Write_Real(std::ostream& out, double value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(double));
+}
+inline void Write_Indices(std::ostream& out, const std::vector<arma::uword>& values) {
+  Write_Integer(out, values.size());
+  for (arma::uword i = 0; i < values.size(); i++)
+    Write_Integer(out, values[i]);
+}
+inline void Write_Flags(std::ostream& out, const std::vector<bool>& values) {
+  Write_Integer(out, values.size());
+  for (arma::uword i = 0; i < values.size(); i++)
+    Write_Integer(out, values[i]);
+}
+inline void Write_Matrix(std::ostream& out, const arma::mat& values) {
+  Write_Integer(out, values.n_rows);
+  Write_Integer(out, values.n_cols);
+  out.write(reinterpret_cast<const char*>(values.memptr()), values.n_elem * sizeof(double));
+}
+
+// Checksum of a block of memory (64-bit FNV-1a over 8-byte words), chained through checksum
+inline std::uint64_t Checksum(const void* data, std::size_t size, std::uint64_t checksum = 14695981039346656037ULL) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  std::uint64_t word;
+  std::size_t i = 0;
+  for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+    std::memcpy(&word, bytes + i, sizeof(std::uint64_t));
+    checksum = (checksum ^ word) * 1099511628211ULL;
+  }
+  for (; i < size; i++)
+    checksum = (checksum ^ bytes[i]) * 1099511628211ULL;
+  return checksum;
+}
+
+// Functions to read values
+const std::size_t binary_header_size = 16;
+inline void Check_Header(const char* header, std::size_t size, const char* magic) {
+  std::uint32_t file_version, file_byte_order;
+  if ((size < binary_header_size) || (std::memcmp(header, magic, 8) != 0))
+    throw std::runtime_error("not a robStepSplitReg binary file of the expected type");
+  std::memcpy(&file_version, header + 8, sizeof(std::uint32_t));
+  std::memcpy(&file_byte_order, header + 12, sizeof(std::uint32_t));
+  if (file_byte_order != binary_byte_order)
+    throw std::runtime_error("binary file written with a different byte order");
+  if (file_version > binary_version)
+    throw std::runtime_error("binary file written by a newer version of the format");
+}
+inline void Read_Header(std::istream& in, const char* magic) {
+  char header[binary_header_size];
+  in.read(header, binary_header_size);
+  Check_Header(header, in ? binary_header_size : 0, magic);
+}
+inline std::uint64_t Read_Integer(std::istream& in) {
+  std::uint64_t value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(std::uint64_t));
+  if (!in)
+    throw std::runtime_error("truncated binary file");
+  return value;
+}
+inline double Read_Real(std::istream& in) {
+  double value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(double));
+  if (!in)
+    throw std::runtime_error("truncated binary file");
+  return value;
+}
+// Functions to read the state of a checkpoint
+// - Sizes and indices are checked against the data of the split before anything is allocated or used,
+//   so a damaged checkpoint is rejected instead of being indexed out of range
+inline std::uint64_t Read_Index(std::istream& in, std::uint64_t bound) {
+  std::uint64_t value = Read_Integer(in);
+  if (value >= bound)
+    throw std::runtime_error("corrupt checkpoint file");
+  return value;
+}
+inline std::vector<arma::uword> Read_Indices(std::istream& in, std::uint64_t max_size, std::uint64_t bound) {
+  std::uint64_t size = Read_Integer(in);
+  if (size > max_size)
+    throw std::runtime_error("corrupt checkpoint file");
+  std::vector<arma::uword> values(size);
+  for (arma::uword i = 0; i < values.size(); i++)
+    values[i] = Read_Index(in, bound);
+  return values;
+}
+inline std::vector<bool> Read_Flags(std::istream& in, std::uint64_t size) {
+  if (Read_Integer(in) != size)
+    throw std::runtime_error("corrupt checkpoint file");
+  std::vector<bool> values(size);
+  for (arma::uword i = 0; i < values.size(); i++)
+    values[i] = (Read_Integer(in) != 0);
+  return values;
+}
+inline arma::mat Read_Matrix(std::istream& in, std::uint64_t n_rows, std::uint64_t max_cols) {
+  std::uint64_t file_rows = Read_Integer(in);
+  std::uint64_t file_cols = Read_Integer(in);
+  if ((file_rows != n_rows) || (file_cols > max_cols))
+    throw std::runtime_error("corrupt checkpoint file");
+  arma::mat values(file_rows, file_cols);
+  in.read(reinterpret_cast<char*>(values.memptr()), values.n_elem * sizeof(double));
+  if (!in)
+    throw std::runtime_error("truncated binary file");
+  return values;
+}
+inline arma::vec Read_Vector(std::istream& in, std::uint64_t n_elem) {
+  arma::mat values = Read_Matrix(in, n_elem, 1);
+  if (values.n_cols != 1)
+    throw std::runtime_error("corrupt checkpoint file");
+  return values.col(0);
+}
+inline void Read_Matrix_Into(std::istream& in, arma::mat& values) {
+  if ((Read_Integer(in) != values.n_rows) || (Read_Integer(in) != values.n_cols))
+    throw std::runtime_error("corrupt checkpoint file");
+  in.read(reinterpret_cast<char*>(values.memptr()), values.n_elem * sizeof(double));
+  if (!in)
+    throw std::runtime_error("truncated binary file");
+}
+
+#endif // Binary_IO_hpp
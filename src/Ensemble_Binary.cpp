@@ -0,0 +1,228 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: Ensemble_Binary.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "Ensemble_Binary.hpp"
+#include "Binary_IO.hpp"
+
+// Libraries included
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Write the ensemble to file
+void Write_Ensemble(const std::string& file,
+                    std::vector<std::vector<arma::uword>>& final_predictors,
+                    std::vector<arma::vec>& coefficients,
+                    std::vector<arma::uword>& path_models,
+                    std::vector<arma::uword>& path_predictors) {
+
+  arma::uword n_models = final_predictors.size();
+  arma::uword path_length = path_models.size();
+  if ((coefficients.size() != n_models) || (path_predictors.size() != path_length))
+    throw std::runtime_error("ensemble with inconsistent models or fit path");
+
+  // Offsets of the arrays (after the header, the counts, the model table and the path offset)
+  std::uint64_t offset = binary_header_size + 8 * (2 + 3 * n_models + 1);
+  std::vector<std::uint64_t> predictors_offset(n_models), coefficients_offset(n_models);
+  for (arma::uword m = 0; m < n_models; m++) {
+
+    if (coefficients[m].n_elem != final_predictors[m].size() + 1)
+      throw std::runtime_error("coefficients do not match the predictors of the model");
+    predictors_offset[m] = offset;
+    offset += 8 * final_predictors[m].size();
+    coefficients_offset[m] = offset;
+    offset += 8 * coefficients[m].n_elem;
+  }
+
+  std::string temporary_file = file + ".tmp";
+  std::ofstream out(temporary_file.c_str(), std::ios::binary | std::ios::trunc);
+  Write_Header(out, ensemble_magic);
+  Write_Integer(out, n_models);
+  Write_Integer(out, path_length);
+  for (arma::uword m = 0; m < n_models; m++) {
+    Write_Integer(out, final_predictors[m].size());
+    Write_Integer(out, predictors_offset[m]);
+    Write_Integer(out, coefficients_offset[m]);
+  }
+  Write_Integer(out, offset);
+  for (arma::uword m = 0; m < n_models; m++) {
+    for (arma::uword pred_id = 0; pred_id < final_predictors[m].size(); pred_id++)
+      Write_Integer(out, final_predictors[m][pred_id]);
+    out.write(reinterpret_cast<const char*>(coefficients[m].memptr()), coefficients[m].n_elem * sizeof(double));
+  }
+  for (arma::uword step = 0; step < path_length; step++)
+    Write_Integer(out, path_models[step]);
+  for (arma::uword step = 0; step < path_length; step++)
+    Write_Integer(out, path_predictors[step]);
+  out.close();
+  if (!out)
+    throw std::runtime_error("ensemble could not be written");
+  if (std::rename(temporary_file.c_str(), file.c_str()) != 0)
+    throw std::runtime_error("ensemble could not be written");
+}
+
+// (+) View Constructor
+
+Ensemble_View::Ensemble_View(const char* data, std::size_t size) :
+  data(data), size(size) {
+
+  Check_Header(data, size, ensemble_magic);
+  const std::uint64_t* counts = reinterpret_cast<const std::uint64_t*>(Checked_Array(binary_header_size, 2));
+  n_models = Checked_Count(counts[0]);
+  path_length = Checked_Count(counts[1]);
+  model_table = reinterpret_cast<const std::uint64_t*>(Checked_Array(binary_header_size + 16, Checked_Sum(Checked_Product(3, n_models), 1)));
+
+  // Bounds of all the arrays are checked once, so the getters can return them directly
+  for (std::uint64_t m = 0; m < n_models; m++) {
+    std::uint64_t n_predictors = Checked_Count(model_table[3 * m]);
+    const std::uint64_t* predictors = reinterpret_cast<const std::uint64_t*>(Checked_Array(model_table[3 * m + 1], n_predictors));
+    Checked_Array(model_table[3 * m + 2], Checked_Sum(n_predictors, 1));
+    for (std::uint64_t pred_id = 0; pred_id < n_predictors; pred_id++)
+      Checked_Count(predictors[pred_id]);
+  }
+  path = reinterpret_cast<const std::uint64_t*>(Checked_Array(model_table[3 * n_models], Checked_Product(2, path_length)));
+  for (std::uint64_t step = 0; step < path_length; step++) {
+    if (path[step] >= n_models)
+      throw std::runtime_error("corrupt ensemble file");
+    Checked_Count(path[path_length + step]);
+  }
+}
+
+// Counts and indices must fit in arma::uword (32 bits unless ARMA_64BIT_WORD is defined)
+std::uint64_t Ensemble_View::Checked_Count(std::uint64_t count) {
+
+  if (count > std::numeric_limits<arma::uword>::max())
+    throw std::runtime_error("corrupt ensemble file (or too large for this build)");
+  return count;
+}
+
+// Arithmetic on the counts of the file without wrapping around
+std::uint64_t Ensemble_View::Checked_Sum(std::uint64_t a, std::uint64_t b) {
+
+  if (a > std::numeric_limits<std::uint64_t>::max() - b)
+    throw std::runtime_error("corrupt ensemble file");
+  return a + b;
+}
+std::uint64_t Ensemble_View::Checked_Product(std::uint64_t a, std::uint64_t b) {
+
+  if ((b != 0) && (a > std::numeric_limits<std::uint64_t>::max() / b))
+    throw std::runtime_error("corrupt ensemble file");
+  return a * b;
+}
+
+const char* Ensemble_View::Checked_Array(std::uint64_t offset, std::uint64_t n_elem) {
+
+  if ((offset % 8 != 0) || (offset > size) || (n_elem > (size - offset) / 8))
+    throw std::runtime_error("corrupt ensemble file");
+  return data + offset;
+}
+
+// (+) Functions that return the ensemble
+arma::uword Ensemble_View::Get_N_Models() {
+  return n_models;
+}
+
+arma::uword Ensemble_View::Get_N_Predictors(arma::uword m) {
+  return model_table[3 * m];
+}
+
+const std::uint64_t* Ensemble_View::Get_Predictors(arma::uword m) {
+  return reinterpret_cast<const std::uint64_t*>(data + model_table[3 * m + 1]);
+}
+
+const double* Ensemble_View::Get_Coefficients(arma::uword m) {
+  return reinterpret_cast<const double*>(data + model_table[3 * m + 2]);
+}
+
+arma::uword Ensemble_View::Get_Path_Length() {
+  return path_length;
+}
+
+const std::uint64_t* Ensemble_View::Get_Path_Models() {
+  return path;
+}
+
+const std::uint64_t* Ensemble_View::Get_Path_Predictors() {
+  return path + path_length;
+}
+
+// (+) Average prediction of the models in the ensemble
+arma::vec Ensemble_View::Predict(arma::mat& x_new) {
+
+  arma::vec predictions = arma::zeros(x_new.n_rows);
+  for (arma::uword m = 0; m < Get_N_Models(); m++) {
+
+    const std::uint64_t* predictors = Get_Predictors(m);
+    const double* model_coefficients = Get_Coefficients(m);
+    predictions += model_coefficients[0];
+    for (arma::uword pred_id = 0; pred_id < Get_N_Predictors(m); pred_id++) {
+      if (predictors[pred_id] >= x_new.n_cols)
+        throw std::runtime_error("new data has fewer predictors than the ensemble");
+      predictions += model_coefficients[pred_id + 1] * x_new.col(predictors[pred_id]);
+    }
+  }
+
+  return (n_models > 0) ? arma::vec(predictions / n_models) : predictions;
+}
+
+// (+) Map Constructor and Destructor
+
+Ensemble_Map::Ensemble_Map(const std::string& file) :
+  data(nullptr), size(0) {
+
+#ifndef _WIN32
+  int descriptor = open(file.c_str(), O_RDONLY);
+  if (descriptor < 0)
+    throw std::runtime_error("ensemble file could not be opened");
+  struct stat file_status;
+  if ((fstat(descriptor, &file_status) == 0) && (file_status.st_size > 0)) {
+    size = file_status.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (mapping != MAP_FAILED)
+      data = static_cast<const char*>(mapping);
+  }
+  close(descriptor);
+  if (data != nullptr)
+    return;
+#endif
+
+  // Fallback: read the file into an aligned buffer
+  std::ifstream in(file.c_str(), std::ios::binary | std::ios::ate);
+  if (!in)
+    throw std::runtime_error("ensemble file could not be opened");
+  size = in.tellg();
+  buffer.resize(size / 8 + 1);
+  in.seekg(0);
+  in.read(reinterpret_cast<char*>(buffer.data()), size);
+  if (!in)
+    throw std::runtime_error("ensemble file could not be read");
+  data = reinterpret_cast<const char*>(buffer.data());
+}
+
+Ensemble_Map::~Ensemble_Map() {
+
+#ifndef _WIN32
+  if (buffer.empty() && (data != nullptr))
+    munmap(const_cast<char*>(data), size);
+#endif
+}
+
+// (+) Function that returns the view of the ensemble
+Ensemble_View Ensemble_Map::Get_View() {
+  return Ensemble_View(data, size);
+}
@@ -0,0 +1,99 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Ensemble_Binary.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Ensemble_Binary_hpp
+#define Ensemble_Binary_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary file of a fitted ensemble (every field is 8 bytes, so all arrays are aligned when mapped)
+// - Header (Binary_IO.hpp), number of models, length of the fit path
+// - Model table: number of predictors, offset of the predictors, offset of the coefficients (per model)
+// - Offset of the fit path
+// - Arrays: predictors (uint64), coefficients (double, intercept first), path models and path predictors (uint64)
+// (offsets are in bytes from the start of the file)
+
+// Write the ensemble to file (through a temporary file, so readers never see a partial file)
+void Write_Ensemble(const std::string& file,
+                    std::vector<std::vector<arma::uword>>& final_predictors,
+                    std::vector<arma::vec>& coefficients,
+                    std::vector<arma::uword>& path_models,
+                    std::vector<arma::uword>& path_predictors);
+
+// Read-only view of an ensemble file in memory (the arrays are used in place, without copies)
+class Ensemble_View {
+
+private:
+
+  // Variables supplied by the user (the buffer must outlive the view)
+  const char* data;
+  std::size_t size;
+
+  // Variables created inside class (counts are kept as read, and checked to fit in arma::uword)
+  std::uint64_t n_models;
+  std::uint64_t path_length;
+  const std::uint64_t* model_table;
+  const std::uint64_t* path;
+
+  // Functions to check the counts and the arrays of the buffer
+  std::uint64_t Checked_Count(std::uint64_t count);
+  std::uint64_t Checked_Sum(std::uint64_t a, std::uint64_t b);
+  std::uint64_t Checked_Product(std::uint64_t a, std::uint64_t b);
+  const char* Checked_Array(std::uint64_t offset, std::uint64_t n_elem);
+
+public:
+
+  // (+) View Constructor
+
+  Ensemble_View(const char* data, std::size_t size);
+
+  // (+) Functions that return the ensemble
+  arma::uword Get_N_Models();
+  arma::uword Get_N_Predictors(arma::uword m);
+  const std::uint64_t* Get_Predictors(arma::uword m);
+  const double* Get_Coefficients(arma::uword m);
+  arma::uword Get_Path_Length();
+  const std::uint64_t* Get_Path_Models();
+  const std::uint64_t* Get_Path_Predictors();
+
+  // (+) Average prediction of the models in the ensemble
+  arma::vec Predict(arma::mat& x_new);
+};
+
+// Ensemble file mapped in memory (read into a buffer where mapping is unavailable)
+class Ensemble_Map {
+
+private:
+
+  // Variables created inside class
+  const char* data;
+  std::size_t size;
+  std::vector<std::uint64_t> buffer;
+
+public:
+
+  // (+) Map Constructor and Destructor
+
+  Ensemble_Map(const std::string& file);
+  ~Ensemble_Map();
+  Ensemble_Map(const Ensemble_Map&) = delete;
+  Ensemble_Map& operator=(const Ensemble_Map&) = delete;
+
+  // (+) Function that returns the view of the ensemble
+  Ensemble_View Get_View();
+};
+
+#endif // Ensemble_Binary_hpp
@@ -0,0 +1,127 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: Ensemble_Prediction.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "Ensemble_Prediction.hpp"
+
+// Libraries included
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Least squares fit of y on the columns of a design by a QR decomposition
+// - arma::solve prints its warnings (e.g. for singular systems) to the R console, which must not happen
+//   outside the main thread (the fits of the cross-validation run in worker threads)
+// - Columns that are numerically linear combinations of the previous columns get a zero coefficient
+bool Least_Squares(arma::mat& design, arma::vec& y, arma::vec& coefficients) {
+  
+  arma::mat Q, R;
+  if (!arma::qr_econ(Q, R, design))
+    return false;
+  
+  // Columns with a component orthogonal to the previous columns
+  arma::vec R_diagonal = arma::abs(R.diag());
+  if (R_diagonal.n_elem == 0)
+    return false;
+  double tolerance = std::max(design.n_rows, design.n_cols) * std::numeric_limits<double>::epsilon() * R_diagonal.max();
+  arma::uvec independent = arma::find(R_diagonal > tolerance);
+  if (independent.n_elem == 0)
+    return false;
+  if (independent.n_elem < design.n_cols) {
+    arma::mat design_independent = design.cols(independent);
+    if (!arma::qr_econ(Q, R, design_independent))
+      return false;
+  }
+  
+  // Back substitution of R * beta = Q'y
+  arma::vec Qy = Q.t() * y;
+  arma::vec beta(independent.n_elem);
+  for (arma::uword j = independent.n_elem; j-- > 0;) {
+    double value = Qy(j);
+    for (arma::uword k = j + 1; k < independent.n_elem; k++)
+      value -= R(j, k) * beta(k);
+    if (std::abs(R(j, j)) <= tolerance)
+      return false;
+    beta(j) = value / R(j, j);
+  }
+  
+  coefficients = arma::zeros(design.n_cols);
+  coefficients.elem(independent) = beta;
+  return true;
+}
+
+// Least squares coefficients (intercept first) of a model on its design (intercept-only fit if the least
+// squares problem cannot be solved)
+arma::vec Model_Coefficients(arma::mat& design, arma::vec& y) {
+  
+  arma::vec model_coefficients;
+  if (!Least_Squares(design, y, model_coefficients)) {
+    model_coefficients = arma::zeros(design.n_cols);
+    model_coefficients(0) = arma::mean(y);
+  }
+  return model_coefficients;
+}
+
+// Least squares coefficients (intercept first) of each model on its predictors
+std::vector<arma::vec> Ensemble_Coefficients(arma::mat& x, arma::vec& y,
+                                             std::vector<std::vector<arma::uword>>& final_predictors) {
+  
+  std::vector<arma::vec> coefficients;
+  for (arma::uword m = 0; m < final_predictors.size(); m++) {
+    
+    arma::uvec predictors = arma::conv_to<arma::uvec>::from(final_predictors[m]);
+    arma::mat design = arma::join_rows(arma::ones(x.n_rows), x.cols(predictors));
+    coefficients.push_back(Model_Coefficients(design, y));
+  }
+  
+  return coefficients;
+}
+std::vector<arma::vec> Ensemble_Coefficients(Row_View& x, arma::vec& y,
+                                             std::vector<std::vector<arma::uword>>& final_predictors) {
+  
+  std::vector<arma::vec> coefficients;
+  for (arma::uword m = 0; m < final_predictors.size(); m++) {
+    
+    arma::uvec predictors = arma::conv_to<arma::uvec>::from(final_predictors[m]);
+    arma::mat design = arma::join_rows(arma::ones(x.n_rows), x.x.submat(x.rows, predictors));
+    coefficients.push_back(Model_Coefficients(design, y));
+  }
+  
+  return coefficients;
+}
+
+// Average prediction of the models in the ensemble
+arma::vec Ensemble_Predictions(arma::mat& x_new,
+                               std::vector<std::vector<arma::uword>>& final_predictors,
+                               std::vector<arma::vec>& coefficients) {
+  
+  arma::vec predictions = arma::zeros(x_new.n_rows);
+  for (arma::uword m = 0; m < final_predictors.size(); m++) {
+    
+    arma::uvec predictors = arma::conv_to<arma::uvec>::from(final_predictors[m]);
+    predictions += coefficients[m](0) + x_new.cols(predictors) * coefficients[m].tail(predictors.n_elem);
+  }
+  
+  return predictions / final_predictors.size();
+}
+arma::vec Ensemble_Predictions(Row_View& x_new,
+                               std::vector<std::vector<arma::uword>>& final_predictors,
+                               std::vector<arma::vec>& coefficients) {
+  
+  arma::vec predictions = arma::zeros(x_new.n_rows);
+  for (arma::uword m = 0; m < final_predictors.size(); m++) {
+    
+    arma::uvec predictors = arma::conv_to<arma::uvec>::from(final_predictors[m]);
+    predictions += coefficients[m](0) + x_new.x.submat(x_new.rows, predictors) * coefficients[m].tail(predictors.n_elem);
+  }
+  
+  return predictions / final_predictors.size();
+}
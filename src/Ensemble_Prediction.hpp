@@ -0,0 +1,41 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Ensemble_Prediction.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Ensemble_Prediction_hpp
+#define Ensemble_Prediction_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <vector>
+
+// Header files included
+#include "Row_View.hpp"
+
+// Least squares coefficients (intercept first) of each model on its predictors
+std::vector<arma::vec> Ensemble_Coefficients(arma::mat& x, arma::vec& y,
+                                             std::vector<std::vector<arma::uword>>& final_predictors);
+
+// Coefficients on the rows of x in a row view (y holds the response of those rows; only the columns of
+// each model are gathered)
+std::vector<arma::vec> Ensemble_Coefficients(Row_View& x, arma::vec& y,
+                                             std::vector<std::vector<arma::uword>>& final_predictors);
+
+// Average prediction of the models in the ensemble
+arma::vec Ensemble_Predictions(arma::mat& x_new,
+                               std::vector<std::vector<arma::uword>>& final_predictors,
+                               std::vector<arma::vec>& coefficients);
+
+// Prediction for the rows of x in a row view
+arma::vec Ensemble_Predictions(Row_View& x_new,
+                               std::vector<std::vector<arma::uword>>& final_predictors,
+                               std::vector<arma::vec>& coefficients);
+
+#endif // Ensemble_Prediction_hpp
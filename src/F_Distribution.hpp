@@ -0,0 +1,121 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: F_Distribution.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef F_Distribution_hpp
+#define F_Distribution_hpp
+
+// Libraries included
+#include <cmath>
+#include <limits>
+
+// Upper tail of the F distribution without the R API
+// - R::pf may raise R warnings, which must not happen outside the main thread (the models of the
+//   batched rounds, the cross-validation and the stability selection are updated by worker threads)
+// - The functions only use local state, so they can be called from any thread
+
+// Logarithm of the gamma function for x > 0 (Lanczos approximation, g = 7)
+inline double Log_Gamma(double x) {
+
+  static const double coefficients[9] = {0.99999999999980993, 676.5203681218851, -1259.1392167224028,
+                                         771.32342877765313, -176.61502916214059, 12.507343278686905,
+                                         -0.13857109526572012, 9.9843695780195716e-6, 1.5056327351493116e-7};
+
+  const double pi = 3.14159265358979323846;
+
+  // Reflection for small arguments
+  if (x < 0.5)
+    return std::log(pi / std::abs(std::sin(pi * x))) - Log_Gamma(1 - x);
+
+  x -= 1;
+  double series = coefficients[0];
+  for (int term = 1; term < 9; term++)
+    series += coefficients[term] / (x + term);
+  double t = x + 7.5;
+  return 0.5 * std::log(2 * pi) + (x + 0.5) * std::log(t) - t + std::log(series);
+}
+
+// Continued fraction of the incomplete beta function (modified Lentz method)
+inline double Incomplete_Beta_Fraction(double a, double b, double x) {
+
+  const double tiny = 1e-300;
+  const double tolerance = 1e-15;
+  const int max_iterations = 100000;
+
+  double c = 1;
+  double d = 1 - (a + b) * x / (a + 1);
+  if (std::abs(d) < tiny)
+    d = tiny;
+  d = 1 / d;
+  double fraction = d;
+
+  for (int m = 1; m <= max_iterations; m++) {
+
+    // Even step
+    double numerator = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+    d = 1 + numerator * d;
+    if (std::abs(d) < tiny)
+      d = tiny;
+    c = 1 + numerator / c;
+    if (std::abs(c) < tiny)
+      c = tiny;
+    d = 1 / d;
+    fraction *= d * c;
+
+    // Odd step
+    numerator = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+    d = 1 + numerator * d;
+    if (std::abs(d) < tiny)
+      d = tiny;
+    c = 1 + numerator / c;
+    if (std::abs(c) < tiny)
+      c = tiny;
+    d = 1 / d;
+    double delta = d * c;
+    fraction *= delta;
+    if (std::abs(delta - 1) < tolerance)
+      break;
+  }
+
+  return fraction;
+}
+
+// Regularized incomplete beta function I_x(a, b)
+inline double Incomplete_Beta(double a, double b, double x) {
+
+  if (x <= 0)
+    return 0;
+  if (x >= 1)
+    return 1;
+
+  double log_front = Log_Gamma(a + b) - Log_Gamma(a) - Log_Gamma(b) + a * std::log(x) + b * std::log1p(-x);
+  double front = std::exp(log_front);
+
+  // The continued fraction converges quickly on the side of the mean of the distribution
+  if (x < (a + 1) / (a + b + 2))
+    return front * Incomplete_Beta_Fraction(a, b, x) / a;
+  return 1 - front * Incomplete_Beta_Fraction(b, a, 1 - x) / b;
+}
+
+// Upper tail probability P(F > F_value) of the F distribution with (df1, df2) degrees of freedom
+// (same value as R::pf(F_value, df1, df2, 0, 0))
+inline double F_Upper_Tail(double F_value, double df1, double df2) {
+
+  if (std::isnan(F_value) || (df1 <= 0) || (df2 <= 0))
+    return std::numeric_limits<double>::quiet_NaN();
+  if (F_value <= 0)
+    return 1;
+  if (std::isinf(F_value))
+    return 0;
+
+  return Incomplete_Beta(df2 / 2, df1 / 2, df2 / (df2 + df1 * F_value));
+}
+
+#endif // F_Distribution_hpp
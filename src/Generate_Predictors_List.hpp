@@ -9,27 +9,17 @@
  * ===========================================================
  */
 
-// Header files included
-#include "StepModel.hpp"
-#include "StepModelFixed.hpp"
+// Libraries included
+#include <RcppArmadillo.h>
+#include <vector>
 
 
 // Return a list of vectors with the variables in each model
-Rcpp::List Generate_Predictors_List(std::vector<StepModel*> final_models, arma::uword& n_models) {
+Rcpp::List Generate_Predictors_List(std::vector<std::vector<arma::uword>>& final_predictors, arma::uword& n_models) {
   
   Rcpp::List final_predictors_list(n_models);
   for (arma::uword m = 0; m < n_models; m++)
-    final_predictors_list[m] = final_models[m]->Get_Model_Predictors();
+    final_predictors_list[m] = final_predictors[m];
   
   return final_predictors_list;
 }
-
-// Return a list of vectors with the variables in each model
-Rcpp::List Generate_Predictors_List_Fixed(std::vector<StepModelFixed*> final_models, arma::uword& n_models) {
-  
-  Rcpp::List final_predictors_list(n_models);
-  for (arma::uword m = 0; m < n_models; m++)
-    final_predictors_list[m] = final_models[m]->Get_Model_Predictors();
-  
-  return final_predictors_list;
-}
\ No newline at end of file
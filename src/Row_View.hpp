@@ -0,0 +1,31 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Row_View.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Row_View_hpp
+#define Row_View_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+
+// Rows of a design matrix used by a fit, without a copy of the rows
+// (the models gather the rows directly into their z matrices)
+struct Row_View {
+
+  arma::mat& x;
+  arma::uvec& rows;
+  arma::uword n_rows;
+  arma::uword n_cols;
+
+  Row_View(arma::mat& x, arma::uvec& rows) :
+    x(x), rows(rows), n_rows(rows.n_elem), n_cols(x.n_cols) {}
+};
+
+#endif // Row_View_hpp
@@ -0,0 +1,195 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: Screening.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "Split_Models.hpp"
+#include "Screening.hpp"
+
+// Excluded predictors that could have replaced a candidate of a model fitted on the working set
+// - The candidate of each model after each of its updates (the next predictor added, or the final candidate)
+//   must have a larger absolute partial correlation than every excluded predictor
+// - The excluded predictors are never formed as columns of z: their partial correlations are
+//   recovered from their inner products with the projection directions of the model
+// - The directions of all the models are stacked, so x is read once for all the models
+arma::uvec Screening_Violations(arma::mat& x, arma::vec& y,
+                                arma::mat& correlation_predictors,
+                                arma::vec& xy, arma::vec& x_norms,
+                                arma::uvec& excluded,
+                                std::vector<std::vector<arma::uword>>& final_predictors,
+                                std::vector<arma::uword>& final_candidates,
+                                bool check_final) {
+
+  // Relative tolerance for the comparisons (ties are treated as violations)
+  const double screening_tolerance = 1e-8;
+  arma::uword n = x.n_rows;
+  arma::uword n_models = final_predictors.size();
+
+  // Candidates of each model after each update, and first column of the directions of each model
+  std::vector<std::vector<arma::uword>> candidates(final_predictors);
+  arma::uvec first_direction = arma::zeros<arma::uvec>(n_models + 1);
+  for (arma::uword m = 0; m < n_models; m++) {
+    if (check_final)
+      candidates[m].push_back(final_candidates[m]);
+    first_direction(m + 1) = first_direction(m) + ((candidates[m].size() < 2) ? 0 : candidates[m].size() - 1);
+  }
+  if ((first_direction(n_models) == 0) || (excluded.n_elem == 0))
+    return arma::uvec();
+
+  // Projection directions and thresholds of each model (as in the update of the z matrix)
+  arma::mat directions(n, first_direction(n_models));
+  arma::vec thresholds(first_direction(n_models));
+  for (arma::uword m = 0; m < n_models; m++) {
+
+    arma::uword n_updates = first_direction(m + 1) - first_direction(m);
+    if (n_updates == 0)
+      continue;
+    arma::mat z_candidates = x.cols(arma::conv_to<arma::uvec>::from(candidates[m]));
+    for (arma::uword update = 0; update < n_updates; update++) {
+
+      arma::uword direction_id = first_direction(m) + update;
+      directions.col(direction_id) = z_candidates.col(update);
+      double direction_norm = arma::dot(directions.col(direction_id), directions.col(direction_id));
+      for (arma::uword cand_id = update + 1; cand_id <= n_updates; cand_id++) {
+        double projection = (update == 0) ? correlation_predictors(candidates[m][cand_id], candidates[m][0]) :
+          arma::dot(z_candidates.col(cand_id), directions.col(direction_id)) / direction_norm;
+        z_candidates.col(cand_id) -= projection * directions.col(direction_id);
+      }
+      thresholds(direction_id) = std::abs(arma::dot(z_candidates.col(update + 1), y) /
+        arma::dot(z_candidates.col(update + 1), z_candidates.col(update + 1)) / std::sqrt(n));
+    }
+  }
+
+  // Inner products of the excluded predictors with the directions of all the models (single pass over x)
+  arma::mat x_directions = (directions.t() * x).t();
+  x_directions = x_directions.rows(excluded);
+  arma::vec directions_y = directions.t() * y;
+
+  // Partial correlations of the excluded predictors after each update of each model
+  arma::uvec violation = arma::zeros<arma::uvec>(excluded.n_elem);
+  for (arma::uword m = 0; m < n_models; m++) {
+
+    arma::uword n_updates = first_direction(m + 1) - first_direction(m);
+    if (n_updates == 0)
+      continue;
+    arma::uword first = first_direction(m);
+    arma::mat directions_gram = directions.cols(first, first + n_updates - 1).t() * directions.cols(first, first + n_updates - 1);
+
+    arma::vec zy = xy.elem(excluded);
+    arma::vec zz = x_norms.elem(excluded);
+    arma::vec first_correlations = correlation_predictors.col(candidates[m][0]);
+    arma::mat projections(excluded.n_elem, n_updates);
+    for (arma::uword update = 0; update < n_updates; update++) {
+
+      arma::vec z_direction = x_directions.col(first + update);
+      if (update > 0)
+        z_direction -= projections.cols(0, update - 1) * directions_gram.submat(0, update, update - 1, update);
+
+      if (update == 0)
+        projections.col(update) = first_correlations.elem(excluded);
+      else
+        projections.col(update) = z_direction / directions_gram(update, update);
+
+      zy -= projections.col(update) * directions_y(first + update);
+      zz += -2 * projections.col(update) % z_direction + arma::square(projections.col(update)) * directions_gram(update, update);
+
+      arma::vec excluded_correlations = arma::abs(zy / zz) / std::sqrt(n);
+      violation.elem(arma::find(excluded_correlations >= (1 - screening_tolerance) * thresholds(first + update))).ones();
+    }
+  }
+
+  return excluded.elem(arma::find(violation));
+}
+
+// Robust stepwise split on the screen_size predictors most correlated with the response,
+// with the working set expanded until the result matches the split on all predictors
+// (checkpoints are only taken by splits on all predictors, since the working set changes between splits)
+std::vector<std::vector<arma::uword>> Split_Models_Screened(arma::mat& x, arma::vec& y,
+                                                            arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                            arma::uword& model_saturation,
+                                                            double& sig_level,
+                                                            arma::uword& model_size,
+                                                            arma::uword& n_models,
+                                                            arma::uword screen_size,
+                                                            arma::uword n_threads,
+                                                            bool batched,
+                                                            Split_Trace* trace,
+                                                            Split_Checkpoint* checkpoint) {
+
+  arma::uword p = x.n_cols;
+  if ((screen_size == 0) || (screen_size >= p))
+    return Split_Models(x, y, correlation_predictors, correlation_response, model_saturation, sig_level, model_size, n_models, n_threads, batched, trace, checkpoint);
+
+  // Inner products shared by the checks of all the models
+  arma::vec xy = x.t() * y;
+  arma::vec x_norms = arma::sum(arma::square(x), 0).t();
+
+  // Initial working set (always contains the first predictor of each model)
+  arma::uvec correlation_index = arma::sort_index(arma::abs(correlation_response), "descend");
+  arma::uvec working_mask = arma::zeros<arma::uvec>(p);
+  arma::uword working_size = std::min(std::max(screen_size, n_models), p);
+  working_mask.elem(correlation_index.head(working_size)).ones();
+
+  while (true) {
+
+    arma::uvec working_set = arma::find(working_mask);
+    arma::uvec excluded = arma::find(working_mask == 0);
+    if (excluded.n_elem == 0)
+      return Split_Models(x, y, correlation_predictors, correlation_response, model_saturation, sig_level, model_size, n_models, n_threads, batched, trace, checkpoint);
+
+    // Split on the working set
+    arma::mat x_working = x.cols(working_set);
+    arma::mat correlation_predictors_working = correlation_predictors.submat(working_set, working_set);
+    arma::vec correlation_response_working = correlation_response.elem(working_set);
+    Split_Trace working_trace;
+    std::vector<std::vector<arma::uword>> final_predictors = Split_Models(x_working, y,
+                                                                          correlation_predictors_working, correlation_response_working,
+                                                                          model_saturation,
+                                                                          sig_level,
+                                                                          model_size,
+                                                                          n_models,
+                                                                          n_threads,
+                                                                          batched,
+                                                                          &working_trace);
+    std::vector<arma::uword>& final_candidates = working_trace.final_candidates;
+
+    // Predictors in the indexing of x
+    arma::uword n_selected = 0;
+    for (arma::uword m = 0; m < n_models; m++) {
+      for (arma::uword pred_id = 0; pred_id < final_predictors[m].size(); pred_id++)
+        final_predictors[m][pred_id] = working_set(final_predictors[m][pred_id]);
+      final_candidates[m] = working_set(final_candidates[m]);
+      n_selected += final_predictors[m].size();
+    }
+    for (arma::uword step = 0; step < working_trace.path_predictors.size(); step++)
+      working_trace.path_predictors[step] = working_set(working_trace.path_predictors[step]);
+
+    // Working set exhausted by the models: double its size
+    if (n_selected >= working_set.n_elem) {
+      working_size = std::min(2 * working_set.n_elem, p);
+      working_mask.elem(correlation_index.head(working_size)).ones();
+      continue;
+    }
+
+    // Add the excluded predictors that could have replaced a candidate
+    arma::uvec violations = Screening_Violations(x, y, correlation_predictors,
+                                                 xy, x_norms,
+                                                 excluded,
+                                                 final_predictors,
+                                                 final_candidates,
+                                                 model_saturation == 0);
+    if (violations.n_elem == 0) {
+      if (trace != nullptr)
+        *trace = working_trace;
+      return final_predictors;
+    }
+    working_mask.elem(violations).ones();
+  }
+}
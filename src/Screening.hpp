@@ -0,0 +1,46 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Screening.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Screening_hpp
+#define Screening_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <vector>
+
+// Header files included
+#include "Split_Models.hpp"
+
+// Excluded predictors that could have replaced a candidate of the models fitted on the working set
+arma::uvec Screening_Violations(arma::mat& x, arma::vec& y,
+                                arma::mat& correlation_predictors,
+                                arma::vec& xy, arma::vec& x_norms,
+                                arma::uvec& excluded,
+                                std::vector<std::vector<arma::uword>>& final_predictors,
+                                std::vector<arma::uword>& final_candidates,
+                                bool check_final);
+
+// Robust stepwise split on the screen_size predictors most correlated with the response,
+// with the working set expanded until the result matches the split on all predictors
+// (checkpoints are only taken by splits on all predictors, since the working set changes between splits)
+std::vector<std::vector<arma::uword>> Split_Models_Screened(arma::mat& x, arma::vec& y,
+                                                            arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                            arma::uword& model_saturation,
+                                                            double& sig_level,
+                                                            arma::uword& model_size,
+                                                            arma::uword& n_models,
+                                                            arma::uword screen_size,
+                                                            arma::uword n_threads = 1,
+                                                            bool batched = false,
+                                                            Split_Trace* trace = nullptr,
+                                                            Split_Checkpoint* checkpoint = nullptr);
+
+#endif // Screening_hpp
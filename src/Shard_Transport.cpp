@@ -0,0 +1,319 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: Shard_Transport.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "Shard_Transport.hpp"
+
+// Libraries included
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#ifndef _WIN32
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// (+) Workers of the Transport
+
+// Fork one worker per shard (each worker leaves through _exit, so no state of the caller is torn down twice)
+void Shard_Transport::Start_Workers(Shard_Worker_Function worker) {
+
+#ifdef _WIN32
+  throw std::runtime_error("the sharded split requires a POSIX platform");
+#else
+  for (arma::uword shard = 0; shard < n_shards; shard++) {
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      int status = 0;
+      try {
+        Attach_Worker(shard);
+        worker(*this);
+      } catch (...) {
+        status = 1;
+      }
+      _exit(status);
+    }
+    if (pid < 0) {
+      for (arma::uword shard_id = 0; shard_id < worker_pids.size(); shard_id++)
+        Terminate_Worker(shard_id);
+      Wait_Workers();
+      throw std::runtime_error("worker process of a shard could not be created");
+    }
+    worker_pids.push_back(pid);
+  }
+  Attach_Coordinator();
+#endif
+}
+
+void Shard_Transport::Terminate_Worker(arma::uword shard) {
+
+#ifndef _WIN32
+  kill(worker_pids[shard], SIGTERM);
+#endif
+}
+
+void Shard_Transport::Wait_Workers() {
+
+#ifndef _WIN32
+  for (arma::uword shard = 0; shard < worker_pids.size(); shard++)
+    waitpid(worker_pids[shard], nullptr, 0);
+#endif
+  worker_pids.clear();
+}
+
+#ifndef _WIN32
+
+// Flag to report a closed socket as an error instead of a signal
+// (where send has no such flag, e.g. macOS, the sockets are created with SO_NOSIGPIPE instead)
+#ifdef MSG_NOSIGNAL
+const int socket_send_flags = MSG_NOSIGNAL;
+#else
+const int socket_send_flags = 0;
+#endif
+
+// (+) Socket Transport
+
+Socket_Transport::Socket_Transport(arma::uword n_shards) :
+  Shard_Transport(n_shards), worker_shard(n_shards) {
+
+  coordinator_sockets.assign(n_shards, -1);
+  worker_sockets.assign(n_shards, -1);
+  for (arma::uword shard = 0; shard < n_shards; shard++) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+      throw std::runtime_error("socket pair of a shard could not be created");
+    coordinator_sockets[shard] = sockets[0];
+    worker_sockets[shard] = sockets[1];
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+    int no_sigpipe = 1;
+    if ((setsockopt(sockets[0], SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe)) != 0) ||
+        (setsockopt(sockets[1], SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe)) != 0))
+      throw std::runtime_error("socket pair of a shard could not be configured");
+#endif
+  }
+}
+
+Socket_Transport::~Socket_Transport() {
+
+  for (arma::uword shard = 0; shard < n_shards; shard++) {
+    if (coordinator_sockets[shard] >= 0)
+      close(coordinator_sockets[shard]);
+    if (worker_sockets[shard] >= 0)
+      close(worker_sockets[shard]);
+  }
+}
+
+// Each process keeps only its own ends, so a peer that exits is seen as a closed socket
+void Socket_Transport::Attach_Worker(arma::uword shard) {
+
+  worker_shard = shard;
+  for (arma::uword shard_id = 0; shard_id < n_shards; shard_id++) {
+    close(coordinator_sockets[shard_id]);
+    coordinator_sockets[shard_id] = -1;
+    if (shard_id != shard) {
+      close(worker_sockets[shard_id]);
+      worker_sockets[shard_id] = -1;
+    }
+  }
+}
+void Socket_Transport::Attach_Coordinator() {
+
+  for (arma::uword shard = 0; shard < n_shards; shard++) {
+    close(worker_sockets[shard]);
+    worker_sockets[shard] = -1;
+  }
+}
+
+void Socket_Transport::Write_Socket(int socket, const char* data, std::size_t size) {
+
+  while (size > 0) {
+    ssize_t written = send(socket, data, size, socket_send_flags);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error("shard channel closed");
+    }
+    data += written;
+    size -= written;
+  }
+}
+void Socket_Transport::Read_Socket(int socket, char* data, std::size_t size) {
+
+  while (size > 0) {
+    ssize_t read_size = recv(socket, data, size, 0);
+    if (read_size < 0 && errno == EINTR)
+      continue;
+    if (read_size <= 0)
+      throw std::runtime_error("shard channel closed");
+    data += read_size;
+    size -= read_size;
+  }
+}
+void Socket_Transport::Send_Socket(int socket, std::vector<double>& message) {
+
+  std::uint64_t message_size = message.size();
+  Write_Socket(socket, reinterpret_cast<const char*>(&message_size), sizeof(std::uint64_t));
+  Write_Socket(socket, reinterpret_cast<const char*>(message.data()), message_size * sizeof(double));
+}
+void Socket_Transport::Receive_Socket(int socket, std::vector<double>& message) {
+
+  std::uint64_t message_size;
+  Read_Socket(socket, reinterpret_cast<char*>(&message_size), sizeof(std::uint64_t));
+  message.resize(message_size);
+  Read_Socket(socket, reinterpret_cast<char*>(message.data()), message_size * sizeof(double));
+}
+
+void Socket_Transport::Send_Shard(arma::uword shard, std::vector<double>& message) {
+  Send_Socket(coordinator_sockets[shard], message);
+}
+void Socket_Transport::Receive_Shard(arma::uword shard, std::vector<double>& message) {
+  Receive_Socket(coordinator_sockets[shard], message);
+}
+void Socket_Transport::Send_Coordinator(std::vector<double>& message) {
+  Send_Socket(worker_sockets[worker_shard], message);
+}
+void Socket_Transport::Receive_Coordinator(std::vector<double>& message) {
+  Receive_Socket(worker_sockets[worker_shard], message);
+}
+
+// (+) Shared Memory Transport
+
+// Slot of a channel (filled is posted by the writer, empty by the reader)
+struct Shared_Memory_Slot {
+  sem_t filled;
+  sem_t empty;
+  std::uint64_t size;
+  double data[1];
+};
+
+Shared_Memory_Transport::Shared_Memory_Transport(arma::uword n_shards, arma::uword message_capacity) :
+  Shard_Transport(n_shards), message_capacity(message_capacity), worker_shard(n_shards), region(nullptr) {
+
+  // Slots are rounded to cache lines, so the two directions of a channel never share a line
+  slot_size = offsetof(Shared_Memory_Slot, data) + message_capacity * sizeof(double);
+  slot_size = (slot_size + 63) / 64 * 64;
+  region_size = 2 * n_shards * slot_size;
+  void* mapping = mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED)
+    throw std::runtime_error("shared memory of the shards could not be mapped");
+  region = static_cast<char*>(mapping);
+
+  for (arma::uword shard = 0; shard < n_shards; shard++)
+    for (int to_worker = 0; to_worker < 2; to_worker++) {
+      Shared_Memory_Slot* slot = Slot(shard, to_worker);
+      if ((sem_init(&slot->filled, 1, 0) != 0) || (sem_init(&slot->empty, 1, 1) != 0)) {
+        munmap(region, region_size);
+        throw std::runtime_error("process-shared semaphores are not supported on this platform");
+      }
+    }
+  coordinator_pid = getpid();
+}
+
+Shared_Memory_Transport::~Shared_Memory_Transport() {
+
+  if (region == nullptr)
+    return;
+  for (arma::uword shard = 0; shard < n_shards; shard++)
+    for (int to_worker = 0; to_worker < 2; to_worker++) {
+      sem_destroy(&Slot(shard, to_worker)->filled);
+      sem_destroy(&Slot(shard, to_worker)->empty);
+    }
+  munmap(region, region_size);
+}
+
+void Shared_Memory_Transport::Attach_Worker(arma::uword shard) {
+  worker_shard = shard;
+}
+void Shared_Memory_Transport::Attach_Coordinator() {
+  // (the slots are shared by all the processes, so the coordinator keeps them all)
+}
+
+Shared_Memory_Slot* Shared_Memory_Transport::Slot(arma::uword shard, bool to_worker) {
+  return reinterpret_cast<Shared_Memory_Slot*>(region + (2 * shard + to_worker) * slot_size);
+}
+
+// Wait on a semaphore of a slot, checking every second that the peer is still running
+// (the coordinator checks its worker, and a worker checks that it has not been orphaned)
+void Shared_Memory_Transport::Wait_Slot(void* semaphore, pid_t peer) {
+
+  while (true) {
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 1;
+    if (sem_timedwait(static_cast<sem_t*>(semaphore), &deadline) == 0)
+      return;
+    if (errno == EINTR)
+      continue;
+    if (errno != ETIMEDOUT)
+      throw std::runtime_error("shard channel closed");
+    if (peer == coordinator_pid) {
+      if (getppid() != coordinator_pid)
+        throw std::runtime_error("shard channel closed");
+    }
+    else {
+      int status;
+      if (waitpid(peer, &status, WNOHANG) != 0)
+        throw std::runtime_error("shard channel closed");
+    }
+  }
+}
+void Shared_Memory_Transport::Send_Slot(Shared_Memory_Slot* slot, std::vector<double>& message, pid_t peer) {
+
+  if (message.size() > message_capacity)
+    throw std::runtime_error("message larger than the shared memory slot");
+  Wait_Slot(&slot->empty, peer);
+  slot->size = message.size();
+  std::memcpy(slot->data, message.data(), message.size() * sizeof(double));
+  sem_post(&slot->filled);
+}
+void Shared_Memory_Transport::Receive_Slot(Shared_Memory_Slot* slot, std::vector<double>& message, pid_t peer) {
+
+  Wait_Slot(&slot->filled, peer);
+  message.assign(slot->data, slot->data + slot->size);
+  sem_post(&slot->empty);
+}
+
+void Shared_Memory_Transport::Send_Shard(arma::uword shard, std::vector<double>& message) {
+  Send_Slot(Slot(shard, true), message, worker_pids[shard]);
+}
+void Shared_Memory_Transport::Receive_Shard(arma::uword shard, std::vector<double>& message) {
+  Receive_Slot(Slot(shard, false), message, worker_pids[shard]);
+}
+void Shared_Memory_Transport::Send_Coordinator(std::vector<double>& message) {
+  Send_Slot(Slot(worker_shard, false), message, coordinator_pid);
+}
+void Shared_Memory_Transport::Receive_Coordinator(std::vector<double>& message) {
+  Receive_Slot(Slot(worker_shard, true), message, coordinator_pid);
+}
+
+#endif // _WIN32
+
+// Create the transport of a sharded split
+Shard_Transport* Create_Shard_Transport(const std::string& transport, arma::uword n_shards, arma::uword message_capacity) {
+
+#ifndef _WIN32
+  if (transport == "socket")
+    return new Socket_Transport(n_shards);
+  if (transport == "shared_memory")
+    return new Shared_Memory_Transport(n_shards, message_capacity);
+  throw std::runtime_error("unknown shard transport (\"socket\" or \"shared_memory\")");
+#else
+  throw std::runtime_error("the sharded split requires a POSIX platform");
+#endif
+}
@@ -0,0 +1,147 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Shard_Transport.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Shard_Transport_hpp
+#define Shard_Transport_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+class Shard_Transport;
+
+// Function run by each worker: it serves the commands of the coordinator through the transport
+// (its data included) until it is stopped
+typedef void (*Shard_Worker_Function)(Shard_Transport& transport);
+
+// Channels between the coordinator and the worker processes of a sharded split
+// - One channel per shard; the transport starts the workers (the local transports create the channels,
+//   fork one worker per shard, and each process then attaches to its own ends)
+// - The workers share no data with the coordinator: everything a shard uses is sent through its channel
+// - Messages are vectors of doubles (indices are stored exactly up to 2^53)
+// - Errors (including a peer that exited) are thrown as std::runtime_error
+class Shard_Transport {
+
+protected:
+
+  // Variables created inside class
+  arma::uword n_shards;
+  std::vector<pid_t> worker_pids;
+
+  // (+) Functions to attach a process to its ends of the channels (after the workers are forked)
+  virtual void Attach_Worker(arma::uword shard) = 0;
+  virtual void Attach_Coordinator() = 0;
+
+public:
+
+  // (+) Transport Constructor and Destructor
+
+  Shard_Transport(arma::uword n_shards) : n_shards(n_shards) {}
+  virtual ~Shard_Transport() {}
+
+  // (+) Functions to start and stop the workers (forked processes for the local transports)
+  virtual void Start_Workers(Shard_Worker_Function worker);
+  virtual void Terminate_Worker(arma::uword shard);
+  virtual void Wait_Workers();
+
+  // (+) Functions of the coordinator
+  virtual void Send_Shard(arma::uword shard, std::vector<double>& message) = 0;
+  virtual void Receive_Shard(arma::uword shard, std::vector<double>& message) = 0;
+
+  // (+) Functions of a worker
+  virtual void Send_Coordinator(std::vector<double>& message) = 0;
+  virtual void Receive_Coordinator(std::vector<double>& message) = 0;
+};
+
+// Channels over Unix domain socket pairs (messages are framed by their length)
+class Socket_Transport : public Shard_Transport {
+
+private:
+
+  // Variables created inside class
+  arma::uword worker_shard;
+  std::vector<int> coordinator_sockets, worker_sockets;
+
+  // Functions to move a block of bytes through a socket
+  void Write_Socket(int socket, const char* data, std::size_t size);
+  void Read_Socket(int socket, char* data, std::size_t size);
+  void Send_Socket(int socket, std::vector<double>& message);
+  void Receive_Socket(int socket, std::vector<double>& message);
+
+  // Functions to attach a process to its ends of the channels
+  void Attach_Worker(arma::uword shard);
+  void Attach_Coordinator();
+
+public:
+
+  // (+) Transport Constructor and Destructor
+
+  Socket_Transport(arma::uword n_shards);
+  ~Socket_Transport();
+
+  // (+) Functions of the coordinator
+  void Send_Shard(arma::uword shard, std::vector<double>& message);
+  void Receive_Shard(arma::uword shard, std::vector<double>& message);
+
+  // (+) Functions of a worker
+  void Send_Coordinator(std::vector<double>& message);
+  void Receive_Coordinator(std::vector<double>& message);
+};
+
+// Channels over a shared memory region (one slot per direction, guarded by process-shared semaphores)
+// - Messages are copied once into the slot, with no system call besides the semaphores
+// - A blocked process periodically checks that its peer is still running
+struct Shared_Memory_Slot;
+class Shared_Memory_Transport : public Shard_Transport {
+
+private:
+
+  // Variables created inside class
+  arma::uword message_capacity;
+  arma::uword worker_shard;
+  std::size_t slot_size;
+  std::size_t region_size;
+  char* region;
+  pid_t coordinator_pid;
+
+  // Functions to access the slots and move a message through them
+  Shared_Memory_Slot* Slot(arma::uword shard, bool to_worker);
+  void Send_Slot(Shared_Memory_Slot* slot, std::vector<double>& message, pid_t peer);
+  void Receive_Slot(Shared_Memory_Slot* slot, std::vector<double>& message, pid_t peer);
+  void Wait_Slot(void* semaphore, pid_t peer);
+
+  // Functions to attach a process to its ends of the channels
+  void Attach_Worker(arma::uword shard);
+  void Attach_Coordinator();
+
+public:
+
+  // (+) Transport Constructor and Destructor
+
+  Shared_Memory_Transport(arma::uword n_shards, arma::uword message_capacity);
+  ~Shared_Memory_Transport();
+
+  // (+) Functions of the coordinator
+  void Send_Shard(arma::uword shard, std::vector<double>& message);
+  void Receive_Shard(arma::uword shard, std::vector<double>& message);
+
+  // (+) Functions of a worker
+  void Send_Coordinator(std::vector<double>& message);
+  void Receive_Coordinator(std::vector<double>& message);
+};
+
+// Create the transport of a sharded split ("socket" or "shared_memory")
+// - message_capacity: largest message in doubles (used by the shared memory slots)
+Shard_Transport* Create_Shard_Transport(const std::string& transport, arma::uword n_shards, arma::uword message_capacity);
+
+#endif // Shard_Transport_hpp
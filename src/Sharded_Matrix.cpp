@@ -0,0 +1,314 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: Sharded_Matrix.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "Sharded_Matrix.hpp"
+
+// Libraries included
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// Commands sent by the coordinator to the shards
+// - setup:   {command, n, p, first, last, n_first} followed by y (n), the block of correlation_response,
+//            the block of rows of correlation_predictors and the block of columns of x (column-major),
+//            each in messages of at most n doubles      -> no reply
+// - update:  {command, model, first_column, direction (n)} -> {found, optimal predictor, |partial correlation|}
+// - remove:  {command, model, predictor}                   -> no reply
+// - optimal: {command, model}                              -> {found, optimal predictor, |partial correlation|}
+// - column:  {command, model, predictor}                   -> column of z (n)
+// - stop:    {command}                                     -> no reply (the worker exits)
+enum Shard_Command { shard_setup, shard_update, shard_remove, shard_optimal, shard_column, shard_stop };
+
+// Size of the messages between the coordinator and the shards
+arma::uword Shard_Message_Capacity(arma::uword n) {
+  return std::max<arma::uword>(n + 3, 6);
+}
+
+// Blocks of a model owned by a shard
+struct Shard_Model {
+  arma::mat z;
+  arma::vec partial_correlations;
+  std::vector<bool> predictor_available;
+};
+
+// Optimal predictor of the block of a model (the first largest absolute partial correlation)
+void Shard_Optimal_Predictor(Shard_Model& model, arma::uword first, std::vector<double>& reply) {
+
+  double block_max = -1;
+  arma::uword block_optimal = 0;
+  for (arma::uword pred_id = 0; pred_id < model.partial_correlations.n_elem; pred_id++)
+    if (model.predictor_available[pred_id] && (std::abs(model.partial_correlations(pred_id)) > block_max)) {
+      block_max = std::abs(model.partial_correlations(pred_id));
+      block_optimal = pred_id;
+    }
+  reply.assign(3, 0);
+  reply[0] = (block_max >= 0);
+  reply[1] = first + block_optimal;
+  reply[2] = block_max;
+}
+
+// Receive an array sent by the coordinator in several messages
+void Shard_Receive_Block(Shard_Transport& transport, double* data, arma::uword n_elem, std::vector<double>& message) {
+
+  arma::uword received = 0;
+  while (received < n_elem) {
+    transport.Receive_Coordinator(message);
+    if (message.size() > n_elem - received)
+      throw std::runtime_error("unexpected message from the coordinator");
+    std::copy(message.begin(), message.end(), data + received);
+    received += message.size();
+  }
+}
+
+// Worker process of a shard: receives its block of the data, then serves the commands of the coordinator
+// on the columns [first, last) (the update is the fused kernel of StepModel restricted to the block,
+// without threads since the shards already run in parallel)
+void Shard_Worker(Shard_Transport& transport) {
+
+  std::vector<Shard_Model> models;
+  std::vector<double> message, reply;
+
+  // Block of the data of the shard
+  transport.Receive_Coordinator(message);
+  if ((message.size() != 6) || (static_cast<Shard_Command>(message[0]) != shard_setup))
+    throw std::runtime_error("unexpected message from the coordinator");
+  arma::uword n = message[1];
+  arma::uword p = message[2];
+  arma::uword first = message[3];
+  arma::uword last = message[4];
+  arma::uword n_first = message[5];
+  arma::vec y(n);
+  arma::vec correlation_response(last - first);
+  arma::mat correlation_predictors(last - first, n_first);
+  arma::mat x(n, last - first);
+  Shard_Receive_Block(transport, y.memptr(), y.n_elem, message);
+  Shard_Receive_Block(transport, correlation_response.memptr(), correlation_response.n_elem, message);
+  Shard_Receive_Block(transport, correlation_predictors.memptr(), correlation_predictors.n_elem, message);
+  Shard_Receive_Block(transport, x.memptr(), x.n_elem, message);
+  const double* y_data = y.memptr();
+
+  while (true) {
+
+    transport.Receive_Coordinator(message);
+    Shard_Command command = static_cast<Shard_Command>(message[0]);
+    if (command == shard_stop)
+      return;
+
+    // Blocks of the model (created on first use, in the order the models are registered)
+    arma::uword model_id = message[1];
+    while (models.size() <= model_id) {
+      Shard_Model model;
+      model.z = x;
+      model.partial_correlations = correlation_response;
+      model.predictor_available.assign(last - first, true);
+      models.push_back(model);
+    }
+    Shard_Model& model = models[model_id];
+
+    if (command == shard_update) {
+
+      arma::uword first_column = message[2];
+      const double* direction = message.data() + 3;
+      double direction_norm = 0;
+      for (arma::uword i = 0; i < n; i++)
+        direction_norm += direction[i] * direction[i];
+
+      for (arma::uword pred_id = 0; pred_id < last - first; pred_id++) {
+
+        if (!model.predictor_available[pred_id])
+          continue;
+        double* z_pred = model.z.colptr(pred_id);
+
+        // Projection coefficient on the direction
+        double projection;
+        if (first_column < p)
+          projection = correlation_predictors(pred_id, first_column);
+        else {
+          double z_cross = 0;
+#pragma omp simd reduction(+:z_cross)
+          for (arma::uword i = 0; i < n; i++)
+            z_cross += z_pred[i] * direction[i];
+          projection = z_cross / direction_norm;
+        }
+
+        // Update of the column with its inner products
+        double z_y = 0, z_z = 0;
+#pragma omp simd reduction(+:z_y,z_z)
+        for (arma::uword i = 0; i < n; i++) {
+          double z_value = z_pred[i] - projection * direction[i];
+          z_pred[i] = z_value;
+          z_y += z_value * y_data[i];
+          z_z += z_value * z_value;
+        }
+        model.partial_correlations(pred_id) = z_y / z_z / std::sqrt(n);
+      }
+      Shard_Optimal_Predictor(model, first, reply);
+      transport.Send_Coordinator(reply);
+    }
+    else if (command == shard_remove) {
+
+      arma::uword pred_id = static_cast<arma::uword>(message[2]) - first;
+      model.predictor_available[pred_id] = false;
+      model.partial_correlations(pred_id) = 0;
+    }
+    else if (command == shard_optimal) {
+
+      Shard_Optimal_Predictor(model, first, reply);
+      transport.Send_Coordinator(reply);
+    }
+    else if (command == shard_column) {
+
+      arma::uword pred_id = static_cast<arma::uword>(message[2]) - first;
+      reply.assign(model.z.colptr(pred_id), model.z.colptr(pred_id) + n);
+      transport.Send_Coordinator(reply);
+    }
+  }
+}
+
+// (+) Matrix Constructor and Destructor
+
+Sharded_Matrix::Sharded_Matrix(arma::mat& x, arma::vec& y,
+                               arma::mat& correlation_predictors, arma::vec& correlation_response,
+                               Shard_Transport& transport,
+                               arma::uword n_shards) :
+  transport(transport), n_shards(n_shards), n_registered(0) {
+
+  n_rows = x.n_rows;
+  n_cols = x.n_cols;
+
+  // Blocks of predictors (one per shard)
+  shard_limits.set_size(n_shards + 1);
+  for (arma::uword shard = 0; shard <= n_shards; shard++)
+    shard_limits(shard) = n_cols * shard / n_shards;
+
+  // Start the workers, and send each shard its block of the data
+  transport.Start_Workers(Shard_Worker);
+  try {
+    for (arma::uword shard = 0; shard < n_shards; shard++) {
+
+      arma::uword first = shard_limits(shard), last = shard_limits(shard + 1);
+      message.resize(6);
+      message[0] = shard_setup;
+      message[1] = n_rows;
+      message[2] = n_cols;
+      message[3] = first;
+      message[4] = last;
+      message[5] = correlation_predictors.n_cols;
+      transport.Send_Shard(shard, message);
+
+      arma::mat correlation_predictors_block = correlation_predictors.rows(first, last - 1);
+      Send_Block(shard, y.memptr(), y.n_elem);
+      Send_Block(shard, correlation_response.memptr() + first, last - first);
+      Send_Block(shard, correlation_predictors_block.memptr(), correlation_predictors_block.n_elem);
+      Send_Block(shard, x.colptr(first), n_rows * (last - first));
+    }
+  } catch (...) {
+    Stop_Workers();
+    throw;
+  }
+}
+
+Sharded_Matrix::~Sharded_Matrix() {
+  Stop_Workers();
+}
+
+// (+) Functions to communicate with the shards
+
+void Sharded_Matrix::Send_Block(arma::uword shard, const double* data, arma::uword n_elem) {
+
+  // Messages of at most n doubles, within the capacity of every transport
+  arma::uword chunk = std::max<arma::uword>(n_rows, 1);
+  for (arma::uword start = 0; start < n_elem; start += chunk) {
+    message.assign(data + start, data + std::min(n_elem, start + chunk));
+    transport.Send_Shard(shard, message);
+  }
+}
+
+void Sharded_Matrix::Stop_Workers() {
+
+  message.assign(1, shard_stop);
+  for (arma::uword shard = 0; shard < n_shards; shard++) {
+    try {
+      transport.Send_Shard(shard, message);
+    } catch (...) {
+      transport.Terminate_Worker(shard);
+    }
+  }
+  transport.Wait_Workers();
+}
+
+// (+) Functions of the models
+
+arma::uword Sharded_Matrix::Owner(arma::uword predictor) {
+  return std::upper_bound(shard_limits.begin(), shard_limits.end(), predictor) - shard_limits.begin() - 1;
+}
+
+bool Sharded_Matrix::Reduce_Optimal_Predictor(arma::uword& optimal_predictor) {
+
+  double max_correlation = -1;
+  for (arma::uword shard = 0; shard < n_shards; shard++) {
+    transport.Receive_Shard(shard, reply);
+    if ((reply[0] != 0) && (reply[2] > max_correlation)) {
+      max_correlation = reply[2];
+      optimal_predictor = reply[1];
+    }
+  }
+  return (max_correlation >= 0);
+}
+
+arma::uword Sharded_Matrix::Register_Model() {
+  return n_registered++;
+}
+
+bool Sharded_Matrix::Update(arma::uword model, arma::uword first_column, arma::vec& direction, arma::uword& optimal_predictor) {
+
+  // Scatter of the direction (all shards update their blocks concurrently)
+  message.resize(3 + n_rows);
+  message[0] = shard_update;
+  message[1] = model;
+  message[2] = first_column;
+  std::copy(direction.begin(), direction.end(), message.begin() + 3);
+  for (arma::uword shard = 0; shard < n_shards; shard++)
+    transport.Send_Shard(shard, message);
+
+  return Reduce_Optimal_Predictor(optimal_predictor);
+}
+
+bool Sharded_Matrix::Optimal_Predictor(arma::uword model, arma::uword& optimal_predictor) {
+
+  message.assign(2, shard_optimal);
+  message[1] = model;
+  for (arma::uword shard = 0; shard < n_shards; shard++)
+    transport.Send_Shard(shard, message);
+
+  return Reduce_Optimal_Predictor(optimal_predictor);
+}
+
+void Sharded_Matrix::Remove(arma::uword model, arma::uword predictor) {
+
+  message.assign(3, shard_remove);
+  message[1] = model;
+  message[2] = predictor;
+  transport.Send_Shard(Owner(predictor), message);
+}
+
+arma::vec Sharded_Matrix::Column(arma::uword model, arma::uword predictor) {
+
+  arma::uword shard = Owner(predictor);
+  message.assign(3, shard_column);
+  message[1] = model;
+  message[2] = predictor;
+  transport.Send_Shard(shard, message);
+  transport.Receive_Shard(shard, reply);
+
+  return arma::vec(reply);
+}
@@ -0,0 +1,93 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Sharded_Matrix.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Sharded_Matrix_hpp
+#define Sharded_Matrix_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <vector>
+
+// Header files included
+#include "Shard_Transport.hpp"
+
+// Design matrix whose predictor columns are split across worker processes (shards)
+// - Each shard owns a contiguous block of columns of x and, for every model, the same block of z,
+//   of the partial correlations and of the available predictors
+// - The blocks of the data are sent to the shards through the transport when they start, so the
+//   workers do not rely on memory inherited from the coordinator
+// - The coordinator holds the state of the models that does not depend on p (residuals, fit statistics)
+//   and drives the shards: an update scatters the z column of the added predictor and reduces the
+//   optimal predictor of each shard
+// - correlation_predictors holds the columns of the correlation matrix for the predictors with the
+//   largest absolute correlations with the response (p x n_models, in decreasing order)
+class Sharded_Matrix {
+
+private:
+
+  // Variables supplied by the user
+  Shard_Transport& transport;
+
+  // Variables created inside class
+  arma::uword n_shards;
+  arma::uvec shard_limits;
+  arma::uword n_registered;
+  std::vector<double> message, reply;
+
+  // Functions to send an array to a shard (in several messages) and to stop the workers
+  void Send_Block(arma::uword shard, const double* data, arma::uword n_elem);
+  void Stop_Workers();
+
+  // Function to find the shard owning a predictor
+  arma::uword Owner(arma::uword predictor);
+
+  // Function to reduce the optimal predictors of the shards (in shard order, as in a single sweep)
+  bool Reduce_Optimal_Predictor(arma::uword& optimal_predictor);
+
+public:
+
+  // Dimensions of the matrix (as for the matrices of the other engines)
+  arma::uword n_rows;
+  arma::uword n_cols;
+
+  // (+) Matrix Constructor and Destructor (the workers are started by the constructor and stopped by the destructor)
+
+  Sharded_Matrix(arma::mat& x, arma::vec& y,
+                 arma::mat& correlation_predictors, arma::vec& correlation_response,
+                 Shard_Transport& transport,
+                 arma::uword n_shards);
+  ~Sharded_Matrix();
+  Sharded_Matrix(const Sharded_Matrix&) = delete;
+  Sharded_Matrix& operator=(const Sharded_Matrix&) = delete;
+
+  // (+) Functions of the models
+
+  // Register a model (its blocks are created by the shards on first use)
+  arma::uword Register_Model();
+
+  // Update z with the direction and return the optimal predictor (false if no predictor is available)
+  // - first_column: column of correlation_predictors used for the first update (n_cols otherwise)
+  bool Update(arma::uword model, arma::uword first_column, arma::vec& direction, arma::uword& optimal_predictor);
+
+  // Optimal predictor of the current partial correlations (false if no predictor is available)
+  bool Optimal_Predictor(arma::uword model, arma::uword& optimal_predictor);
+
+  // Remove a predictor from the available predictors
+  void Remove(arma::uword model, arma::uword predictor);
+
+  // Column of z
+  arma::vec Column(arma::uword model, arma::uword predictor);
+};
+
+// Size of the messages between the coordinator and the shards (in doubles)
+arma::uword Shard_Message_Capacity(arma::uword n);
+
+#endif // Sharded_Matrix_hpp
@@ -0,0 +1,32 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Sparse_Design.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Sparse_Design_hpp
+#define Sparse_Design_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+
+// Sparse design matrix with centered columns, x - 1 * center.t(), without forming the dense matrix
+// (the models fold the centering into their implicit z matrices as one more rank-one term; an empty
+// center leaves the columns as they are)
+struct Sparse_Design {
+
+  arma::sp_mat& x;
+  arma::vec& center;
+  arma::uword n_rows;
+  arma::uword n_cols;
+
+  Sparse_Design(arma::sp_mat& x, arma::vec& center) :
+    x(x), center(center), n_rows(x.n_rows), n_cols(x.n_cols) {}
+};
+
+#endif // Sparse_Design_hpp
@@ -0,0 +1,547 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: Split_Models.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "StepModel.hpp"
+#include "StepModelFixed.hpp"
+#include "StepModelSparse.hpp"
+#include "StepModelFixedSparse.hpp"
+#include "StepModelSharded.hpp"
+#include "StepModelFixedSharded.hpp"
+#include "Split_Models.hpp"
+#include "Binary_IO.hpp"
+
+// Libraries included
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <type_traits>
+
+// Record the predictor added to a model in the fit path (called right after Add_Optimal_Predictor)
+// - A model that cannot add its candidate is saturated instead, so the candidate was added if the model
+//   is not full, and it is still the optimal predictor of the model
+template <typename Model>
+void Record_Addition(Split_Trace* trace, Model* model, arma::uword m){
+  
+  if ((trace == nullptr) || model->Get_Full())
+    return;
+  trace->path_models.push_back(m);
+  trace->path_predictors.push_back(model->Get_Optimal_Predictor());
+}
+
+// Complete the fingerprint of the split recorded in its checkpoints
+void Set_Split_Fingerprint(Split_Checkpoint* checkpoint, std::uint64_t engine, std::uint64_t data_checksum,
+                           arma::uword model_saturation, double sig_level, arma::uword model_size,
+                           arma::uword n_models, bool batched){
+  
+  checkpoint->fingerprint.engine = engine;
+  checkpoint->fingerprint.model_saturation = model_saturation;
+  checkpoint->fingerprint.tuning = (model_saturation == 0) ? sig_level : model_size;
+  checkpoint->fingerprint.n_models = n_models;
+  checkpoint->fingerprint.batched = batched;
+  checkpoint->fingerprint.data_checksum = data_checksum;
+}
+
+// Engines whose state can be checkpointed (the sharded engines keep their state in the worker
+// processes, so the checkpoint functions are not instantiated for them)
+template <typename Model> struct Checkpoint_Support : std::true_type {};
+template <> struct Checkpoint_Support<StepModelSharded> : std::false_type {};
+template <> struct Checkpoint_Support<StepModelFixedSharded> : std::false_type {};
+
+template <typename Model>
+void Save_Split_Checkpoint(Split_Checkpoint*, std::vector<Model*>&, arma::vec&, arma::uword, arma::uword,
+                           Split_Trace*, std::false_type){}
+template <typename Model>
+bool Load_Split_Checkpoint(Split_Checkpoint*, std::vector<Model*>&, arma::uword, arma::vec&, arma::uword&, arma::uword&,
+                           Split_Trace*, std::false_type){
+  return false;
+}
+
+// Save the state of the split once checkpoint->interval seconds have passed since the last checkpoint
+// (written to a temporary file first, so an interrupted write leaves the previous checkpoint intact)
+template <typename Model>
+void Save_Split_Checkpoint(Split_Checkpoint* checkpoint,
+                           std::vector<Model*>& models,
+                           arma::vec& p_values, arma::uword n_pred, arma::uword full_models,
+                           Split_Trace* trace, std::true_type){
+  
+  if ((checkpoint == nullptr) || (checkpoint->file.empty()))
+    return;
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - checkpoint->last_save).count() < checkpoint->interval)
+    return;
+  checkpoint->last_save = now;
+  
+  std::string temporary_file = checkpoint->file + ".tmp";
+  std::ofstream out(temporary_file.c_str(), std::ios::binary | std::ios::trunc);
+  Write_Header(out, checkpoint_magic);
+  Write_Integer(out, checkpoint->fingerprint.engine);
+  Write_Integer(out, checkpoint->fingerprint.model_saturation);
+  Write_Real(out, checkpoint->fingerprint.tuning);
+  Write_Integer(out, checkpoint->fingerprint.n_models);
+  Write_Integer(out, checkpoint->fingerprint.batched);
+  Write_Integer(out, checkpoint->fingerprint.screen_size);
+  Write_Integer(out, checkpoint->fingerprint.data_checksum);
+  for (arma::uword m = 0; m < models.size(); m++)
+    models[m]->Save_State(out);
+  Write_Matrix(out, p_values);
+  Write_Integer(out, n_pred);
+  Write_Integer(out, full_models);
+  Write_Indices(out, (trace == nullptr) ? std::vector<arma::uword>() : trace->path_models);
+  Write_Indices(out, (trace == nullptr) ? std::vector<arma::uword>() : trace->path_predictors);
+  out.close();
+  if (!out)
+    throw std::runtime_error("checkpoint could not be written");
+  if (std::rename(temporary_file.c_str(), checkpoint->file.c_str()) != 0)
+    throw std::runtime_error("checkpoint could not be written");
+}
+
+// Restore the state of the split from its checkpoint (if the checkpoint file exists)
+// - Checkpoints written by a split with other settings or other data are rejected, as are damaged checkpoints
+// - The interval to the first checkpoint is counted from here (the start or the resumption of the split)
+template <typename Model>
+bool Load_Split_Checkpoint(Split_Checkpoint* checkpoint,
+                           std::vector<Model*>& models, arma::uword p,
+                           arma::vec& p_values, arma::uword& n_pred, arma::uword& full_models,
+                           Split_Trace* trace, std::true_type){
+  
+  if ((checkpoint == nullptr) || (checkpoint->file.empty()))
+    return false;
+  checkpoint->last_save = std::chrono::steady_clock::now();
+  std::ifstream in(checkpoint->file.c_str(), std::ios::binary);
+  if (!in)
+    return false;
+  
+  Read_Header(in, checkpoint_magic);
+  if ((Read_Integer(in) != checkpoint->fingerprint.engine) ||
+      (Read_Integer(in) != checkpoint->fingerprint.model_saturation))
+    throw std::runtime_error("checkpoint was written by a split with a different engine or model saturation");
+  if ((Read_Real(in) != checkpoint->fingerprint.tuning) ||
+      (Read_Integer(in) != checkpoint->fingerprint.n_models) ||
+      (Read_Integer(in) != checkpoint->fingerprint.batched) ||
+      (Read_Integer(in) != checkpoint->fingerprint.screen_size))
+    throw std::runtime_error("checkpoint was written by a split with different tuning parameters");
+  if (Read_Integer(in) != checkpoint->fingerprint.data_checksum)
+    throw std::runtime_error("checkpoint was written by a split on different data");
+  for (arma::uword m = 0; m < models.size(); m++)
+    models[m]->Load_State(in);
+  p_values = Read_Vector(in, models.size());
+  n_pred = Read_Integer(in);
+  full_models = Read_Integer(in);
+  if ((n_pred > p) || (full_models > models.size()))
+    throw std::runtime_error("corrupt checkpoint file");
+  std::vector<arma::uword> path_models = Read_Indices(in, p, models.size());
+  std::vector<arma::uword> path_predictors = Read_Indices(in, p, p);
+  if (path_predictors.size() != path_models.size())
+    throw std::runtime_error("corrupt checkpoint file");
+  if (trace != nullptr) {
+    trace->path_models = path_models;
+    trace->path_predictors = path_predictors;
+  }
+  
+  return true;
+}
+
+// Batched rounds of the split algorithm
+// - Every unsaturated model proposes its candidate (if significant when significance is used), models
+//   proposing the same predictor are resolved by p-value, and the winning additions are applied together
+// - The winners update their z matrices in parallel
+template <typename Model>
+void Split_Batched_Rounds(std::vector<Model*>& models,
+                          bool significance, double sig_level,
+                          arma::uword& n_pred, arma::uword p,
+                          arma::uword n_threads,
+                          arma::vec& p_values, arma::uword& full_models,
+                          Split_Trace* trace,
+                          Split_Checkpoint* checkpoint){
+  
+  arma::uword n_models = models.size();
+  while (n_pred < p) {
+    
+    // Models proposing their candidate
+    std::vector<arma::uword> proposing;
+    for (arma::uword m = 0; m < n_models; m++)
+      if ((!models[m]->Get_Full()) && ((!significance) || (models[m]->Get_P_Value() < sig_level)))
+        proposing.push_back(m);
+    if (proposing.empty())
+      break;
+    
+    // Winning models in increasing order of p-value (one model per predictor)
+    std::stable_sort(proposing.begin(), proposing.end(),
+                     [&models](arma::uword a, arma::uword b) { return models[a]->Get_P_Value() < models[b]->Get_P_Value(); });
+    std::vector<arma::uword> winners, claimed;
+    std::vector<bool> winner(n_models, false);
+    for (arma::uword prop_id = 0; (prop_id < proposing.size()) && (n_pred + winners.size() < p); prop_id++) {
+      arma::uword candidate = models[proposing[prop_id]]->Get_Optimal_Predictor();
+      if (std::find(claimed.begin(), claimed.end(), candidate) == claimed.end()) {
+        winners.push_back(proposing[prop_id]);
+        claimed.push_back(candidate);
+        winner[proposing[prop_id]] = true;
+      }
+    }
+    
+    // Add the candidates of the winning models
+    for (arma::uword win_id = 0; win_id < winners.size(); win_id++) {
+      models[winners[win_id]]->Add_Optimal_Predictor();
+      Record_Addition(trace, models[winners[win_id]], winners[win_id]);
+      n_pred++;
+    }
+    
+    // Remove the claimed predictors from the other models
+    for (arma::uword m = 0; m < n_models; m++) {
+      if (winner[m] || models[m]->Get_Full())
+        continue;
+      for (arma::uword claim_id = 0; claim_id + 1 < claimed.size(); claim_id++)
+        models[m]->Remove_Available_Predictor(claimed[claim_id]);
+      models[m]->Remove_Available_Predictor_Update(claimed.back());
+    }
+    for (arma::uword win_id = 0; win_id < winners.size(); win_id++)
+      for (arma::uword claim_id = 0; claim_id < claimed.size(); claim_id++)
+        models[winners[win_id]]->Remove_Available_Predictor(claimed[claim_id]);
+    
+    // Update partial correlations for the winning models
+    // (exceptions of the updates are raised on the calling thread, as they cannot leave the parallel region)
+    std::exception_ptr update_exception = nullptr;
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+    for (arma::uword win_id = 0; win_id < winners.size(); win_id++) {
+      try {
+        models[winners[win_id]]->Find_Optimal_Predictor();
+      } catch (...) {
+#pragma omp critical
+        {
+          if (!update_exception)
+            update_exception = std::current_exception();
+        }
+      }
+    }
+    if (update_exception)
+      std::rethrow_exception(update_exception);
+    
+    // Checkpoint of the split
+    Save_Split_Checkpoint(checkpoint, models, p_values, n_pred, full_models, trace, Checkpoint_Support<Model>());
+  }
+}
+
+// Split algorithm with model saturation based on the significance level
+template <typename Model, typename Matrix>
+std::vector<std::vector<arma::uword>> Split_Models_Significance(Matrix& x, arma::vec& y,
+                                                                arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                                double& sig_level,
+                                                                arma::uword& n_models,
+                                                                arma::uword n_threads,
+                                                                bool batched,
+                                                                Split_Trace* trace,
+                                                                Split_Checkpoint* checkpoint){
+  
+  // Create the memory for the models (through dynamic allocation)
+  std::vector<Model*> models;
+  
+  // Initialize the models through the constructors and add first predictor
+  for (arma::uword m = 0; m < n_models; m++) {
+    
+    models.push_back(new Model(x, y, correlation_predictors, correlation_response, sig_level, batched ? 1 : n_threads));
+    models[m]->Find_First_Predictor(m);
+    models[m]->Add_Optimal_Predictor();
+    Record_Addition(trace, models[m], m);
+  }
+  
+  // Remove initial predictors already used
+  for  (arma::uword m = 0; m < n_models; m++)
+    for (arma::uword r = 0; r < n_models; r++){
+      if(r != m)
+        models[m]->Remove_Available_Predictor(models[r]->Get_Optimal_Predictor());
+    }
+      
+  // Variables for model updates
+  arma::vec p_values = arma::ones(n_models);
+  arma::uword optimal_model;
+  arma::uword full_models = 0;
+  arma::uword n_pred = 0;
+  for (arma::uword m = 0; m < n_models; m++) {
+    
+    p_values(m) = models[m]->Get_P_Value();
+    if (!(models[m]->Get_Full()))
+      n_pred++;
+  }
+  
+  // Resume from the checkpoint of an interrupted split, or find optimal predictor for unsaturated models
+  // (the checkpoint holds the state after the initial sweep, so the sweep is skipped on resumption)
+  if (!Load_Split_Checkpoint(checkpoint, models, x.n_cols, p_values, n_pred, full_models, trace, Checkpoint_Support<Model>()))
+    for (arma::uword m = 0; m < n_models; m++){
+      if (!models[m]->Get_Full()) {
+        models[m]->Find_Optimal_Predictor();
+        p_values[m] = models[m]->Get_P_Value();
+      }
+    }
+  
+  // Looping and adding predictors in batched rounds
+  if (batched)
+    Split_Batched_Rounds(models, true, sig_level, n_pred, x.n_cols, n_threads,
+                         p_values, full_models, trace, checkpoint);
+  
+  // Looping and adding predictors
+  while (!batched && (n_pred < x.n_cols)) {
+    
+    // Find optimal model for update
+    optimal_model = p_values.index_min();
+    
+    // Add optimal predictor
+    if (models[optimal_model]->Get_P_Value() < sig_level) {
+      models[optimal_model]->Add_Optimal_Predictor();
+      Record_Addition(trace, models[optimal_model], optimal_model);
+      n_pred++;
+    }
+    else
+      break; // Update for optimal model is not statistically significant
+    
+    // Remove optimal predictor for non-optimal models
+    for (arma::uword m = 0; m < n_models; m++){
+      if ((!models[m]->Get_Full()) && (m != optimal_model))
+        models[m]->Remove_Available_Predictor_Update(models[optimal_model]->Get_Optimal_Predictor());
+    }
+    
+    // Update partial correlations for optimal model
+    models[optimal_model]->Find_Optimal_Predictor();
+    
+    // Update p-values
+    for (arma::uword m = 0; m < n_models; m++){
+      if (!models[m]->Get_Full()) 
+        p_values[m] = models[m]->Get_P_Value();
+    }
+    
+    // Checkpoint of the split
+    Save_Split_Checkpoint(checkpoint, models, p_values, n_pred, full_models, trace, Checkpoint_Support<Model>());
+  }
+  
+  // Predictors in each model
+  std::vector<std::vector<arma::uword>> final_predictors;
+  for (arma::uword m = 0; m < n_models; m++)
+    final_predictors.push_back(models[m]->Get_Model_Predictors());
+  
+  // Final candidate predictor of each model
+  if (trace != nullptr)
+    for (arma::uword m = 0; m < n_models; m++)
+      trace->final_candidates.push_back(models[m]->Get_Optimal_Predictor());
+  
+  // Delete the models
+  for (arma::uword m = 0; m < n_models; m++)
+    delete(models[m]);
+  
+  return final_predictors;
+}
+
+// Split algorithm with fixed model size
+template <typename Model, typename Matrix>
+std::vector<std::vector<arma::uword>> Split_Models_Size(Matrix& x, arma::vec& y,
+                                                        arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                        arma::uword& model_size,
+                                                        arma::uword& n_models,
+                                                        arma::uword n_threads,
+                                                        bool batched,
+                                                        Split_Trace* trace,
+                                                        Split_Checkpoint* checkpoint){
+  
+  // Create the memory for the models (through dynamic allocation)
+  std::vector<Model*> models;
+  
+  // Initialize the models through the constructors and add first predictor
+  for (arma::uword m = 0; m < n_models; m++) {
+    
+    models.push_back(new Model(x, y, correlation_predictors, correlation_response, model_size, batched ? 1 : n_threads));
+    models[m]->Find_First_Predictor(m);
+    models[m]->Add_Optimal_Predictor();
+    Record_Addition(trace, models[m], m);
+  }
+  
+  // Remove initial predictors already used
+  for  (arma::uword m = 0; m < n_models; m++)
+    for (arma::uword r = 0; r < n_models; r++)
+      if(r != m)
+        models[m]->Remove_Available_Predictor(models[r]->Get_Optimal_Predictor());
+      
+  // Variables for model updates
+  arma::vec p_values = arma::ones(n_models);
+  arma::uword optimal_model;
+  arma::uword full_models = 0; 
+  arma::uword n_pred = 0;
+  for (arma::uword m = 0; m < n_models; m++) {
+    
+    if (!(models[m]->Get_Full()))
+      n_pred++;
+    else
+      full_models++;
+  }
+  
+  // Resume from the checkpoint of an interrupted split, or find optimal predictor for unsaturated models
+  // (the checkpoint holds the state after the initial sweep, so the sweep is skipped on resumption)
+  if (!Load_Split_Checkpoint(checkpoint, models, x.n_cols, p_values, n_pred, full_models, trace, Checkpoint_Support<Model>()))
+    for (arma::uword m = 0; m < n_models; m++){
+      if (!models[m]->Get_Full()) {
+        models[m]->Find_Optimal_Predictor();
+        p_values[m] = models[m]->Get_P_Value();
+      }
+    }
+  
+  // Looping and adding predictors in batched rounds
+  if (batched)
+    Split_Batched_Rounds(models, false, 1, n_pred, x.n_cols, n_threads,
+                         p_values, full_models, trace, checkpoint);
+  
+  // Looping and adding predictors
+  while (!batched && (n_pred < x.n_cols) && (full_models < n_models)) {
+    
+    // Find optimal model for update
+    optimal_model = p_values.index_min();
+    
+    // Add optimal predictor
+    if (!(models[optimal_model]->Get_Full())) {
+      models[optimal_model]->Add_Optimal_Predictor();
+      Record_Addition(trace, models[optimal_model], optimal_model);
+      n_pred++;
+      
+      // Remove optimal predictor for non-optimal models
+      for (arma::uword m = 0; m < n_models; m++){
+        if ((!models[m]->Get_Full()) && (m != optimal_model))
+          models[m]->Remove_Available_Predictor_Update(models[optimal_model]->Get_Optimal_Predictor());
+      }
+      
+      // Update partial correlations for optimal model 
+      models[optimal_model]->Find_Optimal_Predictor();
+    } 
+    else{
+      full_models++;
+      p_values[optimal_model] = 2; 
+    }
+    
+    // Checkpoint of the split
+    Save_Split_Checkpoint(checkpoint, models, p_values, n_pred, full_models, trace, Checkpoint_Support<Model>());
+  }
+  
+  // Predictors in each model
+  std::vector<std::vector<arma::uword>> final_predictors;
+  for (arma::uword m = 0; m < n_models; m++)
+    final_predictors.push_back(models[m]->Get_Model_Predictors());
+  
+  // Final candidate predictor of each model
+  if (trace != nullptr)
+    for (arma::uword m = 0; m < n_models; m++)
+      trace->final_candidates.push_back(models[m]->Get_Optimal_Predictor());
+  
+  // Delete the models
+  for (arma::uword m = 0; m < n_models; m++)
+    delete(models[m]);
+  
+  return final_predictors;
+}
+
+// Run the robust stepwise split algorithm and return the predictors in each model
+std::vector<std::vector<arma::uword>> Split_Models(arma::mat& x, arma::vec& y,
+                                                   arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                   arma::uword& model_saturation,
+                                                   double& sig_level,
+                                                   arma::uword& model_size,
+                                                   arma::uword& n_models,
+                                                   arma::uword n_threads,
+                                                   bool batched,
+                                                   Split_Trace* trace,
+                                                   Split_Checkpoint* checkpoint){
+  
+  // Fingerprint of the split for its checkpoints
+  if ((checkpoint != nullptr) && (!checkpoint->file.empty())) {
+    std::uint64_t data_checksum = Checksum(x.memptr(), x.n_elem * sizeof(double));
+    data_checksum = Checksum(y.memptr(), y.n_elem * sizeof(double), data_checksum);
+    data_checksum = Checksum(correlation_predictors.memptr(), correlation_predictors.n_elem * sizeof(double), data_checksum);
+    data_checksum = Checksum(correlation_response.memptr(), correlation_response.n_elem * sizeof(double), data_checksum);
+    Set_Split_Fingerprint(checkpoint, 0, data_checksum, model_saturation, sig_level, model_size, n_models, batched);
+  }
+  
+  if(model_saturation==0) // Case with p-value
+    return Split_Models_Significance<StepModel>(x, y, correlation_predictors, correlation_response, sig_level, n_models, n_threads, batched, trace, checkpoint);
+  else // Case with fixed model size
+    return Split_Models_Size<StepModelFixed>(x, y, correlation_predictors, correlation_response, model_size, n_models, n_threads, batched, trace, checkpoint);
+}
+
+// Run the robust stepwise split algorithm on the rows of x in a row view
+std::vector<std::vector<arma::uword>> Split_Models(Row_View& x, arma::vec& y,
+                                                   arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                   arma::uword& model_saturation,
+                                                   double& sig_level,
+                                                   arma::uword& model_size,
+                                                   arma::uword& n_models,
+                                                   arma::uword n_threads,
+                                                   bool batched,
+                                                   Split_Trace* trace){
+  
+  if(model_saturation==0) // Case with p-value
+    return Split_Models_Significance<StepModel>(x, y, correlation_predictors, correlation_response, sig_level, n_models, n_threads, batched, trace, nullptr);
+  else // Case with fixed model size
+    return Split_Models_Size<StepModelFixed>(x, y, correlation_predictors, correlation_response, model_size, n_models, n_threads, batched, trace, nullptr);
+}
+
+// Run the robust stepwise split algorithm for a sparse design matrix
+std::vector<std::vector<arma::uword>> Split_Models_Sparse(arma::sp_mat& x, arma::vec& y, arma::vec& column_center,
+                                                          arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                          arma::uword& model_saturation,
+                                                          double& sig_level,
+                                                          arma::uword& model_size,
+                                                          arma::uword& n_models,
+                                                          arma::uword n_threads,
+                                                          bool batched,
+                                                          Split_Trace* trace,
+                                                          Split_Checkpoint* checkpoint){
+  
+  // Fingerprint of the split for its checkpoints
+  if ((checkpoint != nullptr) && (!checkpoint->file.empty())) {
+    std::uint64_t data_checksum = Checksum(x.values, x.n_nonzero * sizeof(double));
+    data_checksum = Checksum(x.row_indices, x.n_nonzero * sizeof(arma::uword), data_checksum);
+    data_checksum = Checksum(x.col_ptrs, (x.n_cols + 1) * sizeof(arma::uword), data_checksum);
+    data_checksum = Checksum(column_center.memptr(), column_center.n_elem * sizeof(double), data_checksum);
+    data_checksum = Checksum(y.memptr(), y.n_elem * sizeof(double), data_checksum);
+    data_checksum = Checksum(correlation_predictors.memptr(), correlation_predictors.n_elem * sizeof(double), data_checksum);
+    data_checksum = Checksum(correlation_response.memptr(), correlation_response.n_elem * sizeof(double), data_checksum);
+    Set_Split_Fingerprint(checkpoint, 1, data_checksum, model_saturation, sig_level, model_size, n_models, batched);
+  }
+  
+  // Columns centered implicitly by the models
+  Sparse_Design x_design(x, column_center);
+  
+  if(model_saturation==0) // Case with p-value
+    return Split_Models_Significance<StepModelSparse>(x_design, y, correlation_predictors, correlation_response, sig_level, n_models, n_threads, batched, trace, checkpoint);
+  else // Case with fixed model size
+    return Split_Models_Size<StepModelFixedSparse>(x_design, y, correlation_predictors, correlation_response, model_size, n_models, n_threads, batched, trace, checkpoint);
+}
+
+// Run the robust stepwise split algorithm with the predictors sharded across worker processes
+std::vector<std::vector<arma::uword>> Split_Models_Sharded(arma::mat& x, arma::vec& y,
+                                                           arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                           arma::uword& model_saturation,
+                                                           double& sig_level,
+                                                           arma::uword& model_size,
+                                                           arma::uword& n_models,
+                                                           arma::uword n_shards,
+                                                           std::string transport,
+                                                           bool batched,
+                                                           Split_Trace* trace){
+  
+  // Transport and shards (the workers are stopped before the transport is released)
+  n_shards = std::max<arma::uword>(1, std::min<arma::uword>(n_shards, x.n_cols));
+  std::unique_ptr<Shard_Transport> shard_transport(Create_Shard_Transport(transport, n_shards, Shard_Message_Capacity(x.n_rows)));
+  Sharded_Matrix x_sharded(x, y, correlation_predictors, correlation_response, *shard_transport, n_shards);
+  
+  if(model_saturation==0) // Case with p-value
+    return Split_Models_Significance<StepModelSharded>(x_sharded, y, correlation_predictors, correlation_response, sig_level, n_models, 1, batched, trace, nullptr);
+  else // Case with fixed model size
+    return Split_Models_Size<StepModelFixedSharded>(x_sharded, y, correlation_predictors, correlation_response, model_size, n_models, 1, batched, trace, nullptr);
+}
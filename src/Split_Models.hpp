@@ -0,0 +1,110 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: Split_Models.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef Split_Models_hpp
+#define Split_Models_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Header files included
+#include "Row_View.hpp"
+
+// Optional outputs of the split
+struct Split_Trace {
+  std::vector<arma::uword> final_candidates; // last candidate predictor of each model
+  std::vector<arma::uword> path_models, path_predictors; // fit path (models and predictors in order of addition)
+};
+
+// Settings and data of a split, recorded in its checkpoints (a checkpoint only resumes the split that wrote it)
+struct Split_Fingerprint {
+  std::uint64_t engine; // 0: dense, 1: sparse
+  std::uint64_t model_saturation;
+  double tuning; // sig_level or model_size, depending on model_saturation
+  std::uint64_t n_models;
+  std::uint64_t batched;
+  std::uint64_t screen_size; // set by the caller (screening stage of the split)
+  std::uint64_t data_checksum; // checksum of x, y and the correlations
+};
+
+// Checkpoints of the split (the split resumes from the file if it exists)
+struct Split_Checkpoint {
+  std::string file;
+  double interval; // seconds between checkpoints
+  std::chrono::steady_clock::time_point last_save; // time of the last checkpoint (set by the split)
+  Split_Fingerprint fingerprint; // completed by the split
+};
+
+// Run the robust stepwise split algorithm and return the predictors in each model
+// - n_threads: number of threads sweeping the predictors of each model (or updating the models in batched mode)
+// - batched: models grow in batched rounds instead of one predictor at a time
+// - trace: receives the last candidate predictor of each model and the fit path (if supplied)
+// - checkpoint: file and interval for checkpoints of the split (if supplied)
+// (no R objects are created, so the function may be called from worker threads)
+std::vector<std::vector<arma::uword>> Split_Models(arma::mat& x, arma::vec& y,
+                                                   arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                   arma::uword& model_saturation,
+                                                   double& sig_level,
+                                                   arma::uword& model_size,
+                                                   arma::uword& n_models,
+                                                   arma::uword n_threads = 1,
+                                                   bool batched = false,
+                                                   Split_Trace* trace = nullptr,
+                                                   Split_Checkpoint* checkpoint = nullptr);
+
+// Run the robust stepwise split algorithm on the rows of x in a row view (y holds the response of those rows)
+// (the rows are gathered directly into the z matrices of the models; checkpoints are not supported)
+// - correlation_predictors holds the columns for the n_models predictors most correlated with the response
+//   on the rows, in decreasing order (p x n_models), as for the sparse design matrix
+std::vector<std::vector<arma::uword>> Split_Models(Row_View& x, arma::vec& y,
+                                                   arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                   arma::uword& model_saturation,
+                                                   double& sig_level,
+                                                   arma::uword& model_size,
+                                                   arma::uword& n_models,
+                                                   arma::uword n_threads = 1,
+                                                   bool batched = false,
+                                                   Split_Trace* trace = nullptr);
+
+// Run the robust stepwise split algorithm for a sparse design matrix
+// - column_center: centers of the columns of x, applied implicitly (an empty vector leaves x uncentered)
+// - correlation_predictors holds the columns for the n_models predictors most correlated with the response
+std::vector<std::vector<arma::uword>> Split_Models_Sparse(arma::sp_mat& x, arma::vec& y, arma::vec& column_center,
+                                                          arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                          arma::uword& model_saturation,
+                                                          double& sig_level,
+                                                          arma::uword& model_size,
+                                                          arma::uword& n_models,
+                                                          arma::uword n_threads = 1,
+                                                          bool batched = false,
+                                                          Split_Trace* trace = nullptr,
+                                                          Split_Checkpoint* checkpoint = nullptr);
+
+// Run the robust stepwise split algorithm with the predictors sharded across n_shards worker processes
+// - transport: channels between the coordinator and the shards ("socket" or "shared_memory")
+// - correlation_predictors is p x n_models, as for the sparse design matrix
+// (the coordinator runs the scheduling loop of Split_Models; checkpoints are not supported)
+std::vector<std::vector<arma::uword>> Split_Models_Sharded(arma::mat& x, arma::vec& y,
+                                                           arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                                           arma::uword& model_saturation,
+                                                           double& sig_level,
+                                                           arma::uword& model_size,
+                                                           arma::uword& n_models,
+                                                           arma::uword n_shards,
+                                                           std::string transport = "socket",
+                                                           bool batched = false,
+                                                           Split_Trace* trace = nullptr);
+
+#endif // Split_Models_hpp
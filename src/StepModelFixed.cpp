@@ -11,29 +11,67 @@
 
 // Header files included
 #include "StepModelFixed.hpp"
+#include "F_Distribution.hpp"
+#include "Binary_IO.hpp"
 
 // (+) Model Constructor
 
 StepModelFixed::StepModelFixed(arma::mat& x, arma::vec& y,
                                arma::mat& correlation_predictors, arma::vec& correlation_response,
-                               arma::uword& model_size) :
+                               arma::uword& model_size,
+                               arma::uword n_threads) :
   x(x), y(y),
   correlation_predictors(correlation_predictors), correlation_response(correlation_response),
-  model_size(model_size){
+  model_size(model_size), n_threads(n_threads) {
+  
+  compact_correlations = false;
+  Initialize_Model(nullptr);
+}
+
+StepModelFixed::StepModelFixed(Row_View& x_rows, arma::vec& y,
+                               arma::mat& correlation_predictors, arma::vec& correlation_response,
+                               arma::uword& model_size,
+                               arma::uword n_threads) :
+  x(x_rows.x), y(y),
+  correlation_predictors(correlation_predictors), correlation_response(correlation_response),
+  model_size(model_size), n_threads(n_threads) {
+  
+  compact_correlations = true;
+  Initialize_Model(&x_rows.rows);
+}
+
+// Function to initialize the model
+void StepModelFixed::Initialize_Model(const arma::uvec* rows) {
   
   // Initialize dimension of data
-  n = x.n_rows;
+  n = (rows == nullptr) ? x.n_rows : rows->n_elem;
   p = x.n_cols;
   
   // Initialize available predictors
-  for (arma::uword pred_id = 0; pred_id < p; pred_id++)
-    available_predictors.push_back(pred_id);
+  predictor_available.assign(p, true);
   
   // Initialize partial correlations
   partial_correlations = correlation_response;
   
-  // Initialize z matrices
-  z_old = z_new = x;
+  // Initialize blocks of predictors (one per thread)
+  n_blocks = std::max<arma::uword>(1, std::min(n_threads, p));
+  block_limits.set_size(n_blocks + 1);
+  for (arma::uword block = 0; block <= n_blocks; block++)
+    block_limits(block) = p * block / n_blocks;
+  
+  // Initialize z matrix (updated in place by the sweeps)
+  // - Each block is first touched by the thread that sweeps it, so its pages are allocated
+  //   on the NUMA node of that thread (with bound threads, e.g. OMP_PROC_BIND=true)
+  z.set_size(n, p);
+#pragma omp parallel for schedule(static, 1) num_threads(n_blocks)
+  for (arma::uword block = 0; block < n_blocks; block++)
+    for (arma::uword pred_id = block_limits(block); pred_id < block_limits(block + 1); pred_id++) {
+      if (rows == nullptr)
+        z.col(pred_id) = x.col(pred_id);
+      else
+        for (arma::uword i = 0; i < n; i++)
+          z(i, pred_id) = x((*rows)(i), pred_id);
+    }
   
   // Initialize residuals
   residuals_old = residuals_new = y;
@@ -50,8 +88,9 @@ void StepModelFixed::Find_First_Predictor(arma::uword index) {
   
   arma::uvec correlation_index = arma::sort_index(arma::abs(correlation_response), "descend");
   optimal_predictor = correlation_index(index);
+  first_column = compact_correlations ? index : optimal_predictor;
   beta_y_optimal = correlation_response(optimal_predictor);
-  residuals_new = y - beta_y_optimal * x.col(optimal_predictor);
+  residuals_new = y - beta_y_optimal * z.col(optimal_predictor);
   Update_RSS();
   Update_F_Value();
   Update_P_Value();
@@ -61,9 +100,7 @@ void StepModelFixed::Find_First_Predictor(arma::uword index) {
 // Function for finding optimal predictor (beyond first two predictors)
 void StepModelFixed::Find_Optimal_Predictor() {
   
-  Update_Z_Matrix();
-  Update_Partial_Correlations();
-  Update_Optimal_Predictor();
+  Update_Z_Matrix_Partial_Correlations();
   Update_Beta_Y_Optimal();
   Update_Residuals();
   Update_RSS();
@@ -80,7 +117,6 @@ void StepModelFixed::Add_Optimal_Predictor() {
     Remove_Available_Predictor(optimal_predictor);
     residuals_old = residuals_new;
     rss_old = rss_new;
-    z_old = z_new;
   }
   else
     model_full = true;
@@ -92,16 +128,12 @@ void StepModelFixed::Add_Model_Predictor(arma::uword& predictor) {
 }
 void StepModelFixed::Remove_Available_Predictor(arma::uword predictor) {
   
-  std::vector<arma::uword>::iterator drop_position = std::find(available_predictors.begin(), available_predictors.end(), predictor);
-  if (drop_position != available_predictors.end())
-    available_predictors.erase(drop_position);
+  predictor_available[predictor] = false;
   partial_correlations(predictor) = 0;
 }
 void StepModelFixed::Remove_Available_Predictor_Update(arma::uword predictor) {
   
-  std::vector<arma::uword>::iterator drop_position = std::find(available_predictors.begin(), available_predictors.end(), predictor);
-  if (drop_position != available_predictors.end())
-    available_predictors.erase(drop_position);
+  predictor_available[predictor] = false;
   partial_correlations(predictor) = 0;
   Update_Optimal_Predictor();
   Update_Beta_Y_Optimal();
@@ -112,40 +144,85 @@ void StepModelFixed::Remove_Available_Predictor_Update(arma::uword predictor) {
   Check_Full();
 }
 
-// Function to update z matrix
-void StepModelFixed::Update_Z_Matrix() {
+// Function to update z matrix, partial correlations and optimal predictor in a single pass
+// - Each available column of z is updated in place and its inner products with y and itself are
+//   accumulated while it is in cache, and only available columns are touched
+// - The column of the added predictor is unavailable, so it is read by the sweep but never rewritten
+// - Each block of predictors is swept by the thread that first touched it, and only the
+//   optimal predictor of each block is combined across threads
+void StepModelFixed::Update_Z_Matrix_Partial_Correlations() {
   
-  if (model_predictors.size() == 1) {
-    for (arma::uword pred_id = 0; pred_id < p; pred_id++)
-      z_new.col(pred_id) = z_old.col(pred_id) - arma::as_scalar(correlation_predictors(pred_id, optimal_predictor)) * z_old.col(optimal_predictor);
-  }
-  else {
-    for (arma::uword pred_id = 0; pred_id < p; pred_id++)
-      z_new.col(pred_id) = z_old.col(pred_id) - (arma::as_scalar(z_old.col(pred_id).t() * z_old.col(optimal_predictor)) / arma::as_scalar(z_old.col(optimal_predictor).t() * z_old.col(optimal_predictor))) * z_old.col(optimal_predictor);
+  arma::uword added_predictor = optimal_predictor;
+  const double* z_optimal = z.colptr(added_predictor);
+  const double* y_data = y.memptr();
+  double z_optimal_norm = arma::dot(z.col(added_predictor), z.col(added_predictor));
+  bool first_update = (model_predictors.size() == 1);
+  
+  // Optimal predictor of each block
+  arma::vec block_max = -arma::ones(n_blocks);
+  arma::uvec block_optimal = arma::zeros<arma::uvec>(n_blocks);
+  
+#pragma omp parallel for schedule(static, 1) num_threads(n_blocks)
+  for (arma::uword block = 0; block < n_blocks; block++) {
+    for (arma::uword pred_id = block_limits(block); pred_id < block_limits(block + 1); pred_id++) {
+      
+      if (!predictor_available[pred_id])
+        continue;
+      
+      double* z_pred = z.colptr(pred_id);
+      
+      // Projection coefficient on the optimal predictor
+      double projection;
+      if (first_update)
+        projection = correlation_predictors(pred_id, first_column);
+      else {
+        double z_cross = 0;
+#pragma omp simd reduction(+:z_cross)
+        for (arma::uword i = 0; i < n; i++)
+          z_cross += z_pred[i] * z_optimal[i];
+        projection = z_cross / z_optimal_norm;
+      }
+      
+      // Update of the column with its inner products
+      double z_y = 0, z_z = 0;
+#pragma omp simd reduction(+:z_y,z_z)
+      for (arma::uword i = 0; i < n; i++) {
+        double z_value = z_pred[i] - projection * z_optimal[i];
+        z_pred[i] = z_value;
+        z_y += z_value * y_data[i];
+        z_z += z_value * z_value;
+      }
+      
+      // Partial correlation and running optimal predictor of the block
+      partial_correlations(pred_id) = z_y / z_z / std::sqrt(n);
+      if (std::abs(partial_correlations(pred_id)) > block_max(block)) {
+        block_max(block) = std::abs(partial_correlations(pred_id));
+        block_optimal(block) = pred_id;
+      }
+    }
   }
+  
+  // Optimal predictor over the blocks (in block order, as in a single sweep)
+  double max_correlation = -1;
+  for (arma::uword block = 0; block < n_blocks; block++)
+    if (block_max(block) > max_correlation) {
+      max_correlation = block_max(block);
+      optimal_predictor = block_optimal(block);
+    }
 }
 
 // Functions to update model status
-void StepModelFixed::Update_Partial_Correlations() {
-  
-  begin_iterator = available_predictors.begin();
-  end_iterator = begin_iterator + available_predictors.size();
-  for (auto pred_id = begin_iterator; pred_id != end_iterator; pred_id++) {
-    partial_correlations(*pred_id) =
-      arma::as_scalar(z_new.col(*pred_id).t() * y) / arma::as_scalar(z_new.col(*pred_id).t() * z_new.col(*pred_id)) / std::sqrt(n);
-  }
-}
 void StepModelFixed::Update_Optimal_Predictor() {
   
   optimal_predictor = arma::abs(partial_correlations).index_max();
 }
 void StepModelFixed::Update_Beta_Y_Optimal() {
   
-  beta_y_optimal = arma::as_scalar((z_new.col(optimal_predictor).t() * y)) / arma::as_scalar((z_new.col(optimal_predictor).t() * z_new.col(optimal_predictor)));
+  beta_y_optimal = arma::as_scalar((z.col(optimal_predictor).t() * y)) / arma::as_scalar((z.col(optimal_predictor).t() * z.col(optimal_predictor)));
 }
 void StepModelFixed::Update_Residuals() {
   
-  residuals_new = residuals_old - beta_y_optimal * z_new.col(optimal_predictor);
+  residuals_new = residuals_old - beta_y_optimal * z.col(optimal_predictor);
 }
 void StepModelFixed::Update_RSS() {
   
@@ -157,7 +234,7 @@ void StepModelFixed::Update_F_Value() {
 }
 void StepModelFixed::Update_P_Value() {
   
-  p_value = R::pf(F_value, 1, n - model_predictors.size() - 1, 0, 0);
+  p_value = F_Upper_Tail(F_value, 1, n - model_predictors.size() - 1);
 }
 
 void StepModelFixed::Check_Full() {
@@ -166,6 +243,44 @@ void StepModelFixed::Check_Full() {
     model_full = true;
 }
 
+// (+) Functions to checkpoint the state of the model
+void StepModelFixed::Save_State(std::ostream& out) {
+  
+  Write_Integer(out, n);
+  Write_Integer(out, p);
+  Write_Indices(out, model_predictors);
+  Write_Flags(out, predictor_available);
+  Write_Matrix(out, partial_correlations);
+  Write_Matrix(out, residuals_old);
+  Write_Matrix(out, residuals_new);
+  Write_Matrix(out, z);
+  Write_Integer(out, optimal_predictor);
+  Write_Real(out, beta_y_optimal);
+  Write_Real(out, rss_old);
+  Write_Real(out, rss_new);
+  Write_Real(out, F_value);
+  Write_Real(out, p_value);
+  Write_Integer(out, model_full);
+}
+void StepModelFixed::Load_State(std::istream& in) {
+  
+  if ((Read_Integer(in) != n) || (Read_Integer(in) != p))
+    throw std::runtime_error("checkpoint does not match the dimensions of the data");
+  model_predictors = Read_Indices(in, p, p);
+  predictor_available = Read_Flags(in, p);
+  partial_correlations = Read_Vector(in, p);
+  residuals_old = Read_Vector(in, n);
+  residuals_new = Read_Vector(in, n);
+  Read_Matrix_Into(in, z);
+  optimal_predictor = Read_Index(in, p);
+  beta_y_optimal = Read_Real(in);
+  rss_old = Read_Real(in);
+  rss_new = Read_Real(in);
+  F_value = Read_Real(in);
+  p_value = Read_Real(in);
+  model_full = (Read_Integer(in) != 0);
+}
+
 // (+) Functions that return the state of the model
 bool StepModelFixed::Get_Full() {
   return model_full;
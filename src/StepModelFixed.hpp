@@ -15,26 +15,36 @@
 // Libraries included
 #include <RcppArmadillo.h>
 #include <vector>
+#include <istream>
+#include <ostream>
+
+// Header files included
+#include "Row_View.hpp"
 
 class StepModelFixed {
   
 private:
   
-  // Variables supplied by the user
-  arma::mat x;
-  arma::vec y;
-  arma::mat correlation_predictors;
-  arma::vec correlation_response;
+  // Variables supplied by the user (shared with the caller, not copied)
+  arma::mat& x;
+  arma::vec& y;
+  arma::mat& correlation_predictors;
+  arma::vec& correlation_response;
   arma::uword model_size;
+  arma::uword n_threads;
   
   // Variables created inside class
   arma::uword n;
   arma::uword p;
-  std::vector<arma::uword> model_predictors, available_predictors;
-  std::vector<arma::uword>::iterator begin_iterator, end_iterator;
+  std::vector<arma::uword> model_predictors;
+  std::vector<bool> predictor_available;
+  arma::uword n_blocks;
+  arma::uvec block_limits;
   arma::vec partial_correlations;
   arma::uword optimal_predictor;
-  arma::mat z_old, z_new;
+  bool compact_correlations;
+  arma::uword first_column;
+  arma::mat z;
   double beta_y_optimal;
   arma::vec residuals_old, residuals_new;
   double rss_old, rss_new;
@@ -48,7 +58,20 @@ public:
   
   StepModelFixed(arma::mat& x, arma::vec& y,
                  arma::mat& correlation_predictors, arma::vec& correlation_response,
-                 arma::uword& model_size);
+                 arma::uword& model_size,
+                 arma::uword n_threads = 1);
+  
+  // Model on the rows of x in a row view (y holds the response of those rows)
+  // - The correlations are those of the rows, so correlation_predictors only holds the columns for the
+  //   predictors most correlated with the response (p x n_models, in decreasing order), as for the
+  //   sparse engine
+  StepModelFixed(Row_View& x_rows, arma::vec& y,
+                 arma::mat& correlation_predictors, arma::vec& correlation_response,
+                 arma::uword& model_size,
+                 arma::uword n_threads = 1);
+  
+  // Function to initialize the model (rows: rows of x gathered into z, all rows if nullptr)
+  void Initialize_Model(const arma::uvec* rows);
   
   // (+) Functions that update the current state of the model  
   
@@ -62,11 +85,10 @@ public:
   void Remove_Available_Predictor(arma::uword predictor);
   void Remove_Available_Predictor_Update(arma::uword predictor);
   
-  // Function to update z matrix
-  void Update_Z_Matrix();
+  // Function to update z matrix, partial correlations and optimal predictor in a single pass
+  void Update_Z_Matrix_Partial_Correlations();
   
   // Functions to update model status
-  void Update_Partial_Correlations();
   void Update_Optimal_Predictor();
   void Update_Beta_Y_Optimal();
   void Update_Residuals();
@@ -75,6 +97,10 @@ public:
   void Update_P_Value();
   void Check_Full();
   
+  // (+) Functions to checkpoint the state of the model (the data are supplied again to the constructor)
+  void Save_State(std::ostream& out);
+  void Load_State(std::istream& in);
+  
   // (+) Functions that return the state of the model
   bool Get_Full();
   double Get_F_Value();
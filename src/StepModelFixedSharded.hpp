@@ -0,0 +1,91 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: StepModelFixedSharded.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef StepModelFixedSharded_hpp
+#define StepModelFixedSharded_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <vector>
+
+// Header files included
+#include "Sharded_Matrix.hpp"
+
+// Stepwise model of fixed size over a sharded design matrix
+// - The z matrix and the partial correlations live in the shards; the model only keeps the z column
+//   of its optimal predictor (the direction of its next update)
+// - correlation_predictors is p x n_models, as for the sparse engine
+
+class StepModelFixedSharded {
+
+private:
+
+  // Variables supplied by the user (shared with the caller, not copied)
+  Sharded_Matrix& x;
+  arma::vec& y;
+  arma::mat& correlation_predictors;
+  arma::vec& correlation_response;
+  arma::uword model_size;
+
+  // Variables created inside class
+  arma::uword n;
+  arma::uword p;
+  arma::uword model_id;
+  std::vector<arma::uword> model_predictors;
+  arma::uword optimal_predictor;
+  arma::uword first_index;
+  arma::vec z_optimal;
+  double beta_y_optimal;
+  arma::vec residuals_old, residuals_new;
+  double rss_old, rss_new;
+  double F_value;
+  double p_value;
+  bool model_full;
+
+public:
+
+  // (+) Model Constructor (threads are not used: the shards run in parallel)
+
+  StepModelFixedSharded(Sharded_Matrix& x, arma::vec& y,
+                        arma::mat& correlation_predictors, arma::vec& correlation_response,
+                        arma::uword& model_size,
+                        arma::uword n_threads = 1);
+
+  // (+) Functions that update the current state of the model
+
+  // Functions to potentially add a predictor
+  void Find_First_Predictor(arma::uword index);
+  void Find_Optimal_Predictor();
+  void Add_Optimal_Predictor();
+
+  // Functions to add or remove a predictor
+  void Add_Model_Predictor(arma::uword& predictor);
+  void Remove_Available_Predictor(arma::uword predictor);
+  void Remove_Available_Predictor_Update(arma::uword predictor);
+
+  // Functions to update model status
+  void Update_Z_Optimal();
+  void Update_Beta_Y_Optimal();
+  void Update_Residuals();
+  void Update_RSS();
+  void Update_F_Value();
+  void Update_P_Value();
+  void Check_Full();
+
+  // (+) Functions that return the state of the model
+  bool Get_Full();
+  double Get_F_Value();
+  double Get_P_Value();
+  arma::uword Get_Optimal_Predictor();
+  std::vector<arma::uword> Get_Model_Predictors();
+};
+
+#endif // StepModelFixedSharded_hpp
@@ -0,0 +1,112 @@
+/*
+ * ===========================================================
+ * File Type: HPP
+ * File Name: StepModelFixedSparse.hpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+#ifndef StepModelFixedSparse_hpp
+#define StepModelFixedSparse_hpp
+
+// Libraries included
+#include <RcppArmadillo.h>
+#include <vector>
+#include <istream>
+#include <ostream>
+
+// Header files included
+#include "Sparse_Design.hpp"
+
+// Stepwise model with fixed model size for a sparse design matrix
+// - The z matrix is never formed: z = x - projection_directions * projection_coefficients.t(),
+//   so each step costs O(nnz(x) + (n + p) * model size)
+// - The centering of the columns is the first projection (direction 1, coefficients the centers),
+//   so the model works on the same centered columns as the dense engine without densifying x
+// - correlation_predictors only holds the columns of the correlation matrix for the predictors
+//   with the largest absolute correlations with the response (p x n_models, in decreasing order)
+
+class StepModelFixedSparse {
+
+private:
+
+  // Variables supplied by the user (shared with the caller, not copied)
+  arma::sp_mat& x;
+  arma::vec& y;
+  arma::mat& correlation_predictors;
+  arma::vec& correlation_response;
+  arma::uword model_size;
+  arma::uword n_threads;
+
+  // Variables created inside class
+  arma::uword n;
+  arma::uword p;
+  std::vector<arma::uword> model_predictors, available_predictors;
+  std::vector<arma::uword>::iterator begin_iterator, end_iterator;
+  arma::vec partial_correlations;
+  arma::uword optimal_predictor;
+  arma::uword first_index;
+  arma::mat projection_directions, projection_coefficients;
+  arma::vec direction_new, coefficients_new;
+  bool projection_pending;
+  arma::vec zy_old, zy_new, zz_old, zz_new;
+  double beta_y_optimal;
+  arma::vec residuals_old, residuals_new;
+  double rss_old, rss_new;
+  double F_value;
+  double p_value;
+  bool model_full;
+
+public:
+
+  // (+) Model Constructor
+
+  StepModelFixedSparse(Sparse_Design& x_design, arma::vec& y,
+                       arma::mat& correlation_predictors, arma::vec& correlation_response,
+                       arma::uword& model_size,
+                       arma::uword n_threads = 1);
+
+  // (+) Functions that update the current state of the model
+
+  // Functions to potentially add a predictor
+  void Find_First_Predictor(arma::uword index);
+  void Find_Optimal_Predictor();
+  void Add_Optimal_Predictor();
+
+  // Functions to add or remove a predictor
+  void Add_Model_Predictor(arma::uword& predictor);
+  void Remove_Available_Predictor(arma::uword predictor);
+  void Remove_Available_Predictor_Update(arma::uword predictor);
+
+  // Functions to update z matrix
+  void Update_Z_Matrix();
+  arma::vec X_Column(arma::uword predictor);
+  arma::vec Z_Old_Column(arma::uword predictor);
+  arma::vec Z_New_Column(arma::uword predictor);
+
+  // Functions to update model status
+  void Update_Partial_Correlations();
+  void Update_Optimal_Predictor();
+  void Update_Beta_Y_Optimal();
+  void Update_Residuals();
+  void Update_RSS();
+  void Update_F_Value();
+  void Update_P_Value();
+  void Check_Full();
+
+  // (+) Functions to checkpoint the state of the model (the data are supplied again to the constructor)
+  void Save_State(std::ostream& out);
+  void Load_State(std::istream& in);
+
+  // (+) Functions that return the state of the model
+  bool Get_Full();
+  double Get_F_Value();
+  double Get_P_Value();
+  arma::uword Get_Optimal_Predictor();
+  std::vector<arma::uword> Get_Model_Predictors();
+};
+
+#endif // StepModelFixedSparse_hpp
@@ -0,0 +1,166 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: StepModelSharded.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "StepModelSharded.hpp"
+#include "F_Distribution.hpp"
+
+// (+) Model Constructor
+
+StepModelSharded::StepModelSharded(Sharded_Matrix& x, arma::vec& y,
+                                   arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                   double& sig_level,
+                                   arma::uword) :
+  x(x), y(y),
+  correlation_predictors(correlation_predictors), correlation_response(correlation_response),
+  sig_level(sig_level) {
+
+  // Initialize dimension of data
+  n = x.n_rows;
+  p = x.n_cols;
+
+  // Initialize the blocks of the model in the shards
+  model_id = x.Register_Model();
+
+  // Initialize residuals
+  residuals_old = residuals_new = y;
+  rss_old = rss_new = arma::as_scalar(y.t()*y);
+
+  // Initialize model saturation
+  model_full = false;
+}
+
+// (+) Functions that update the current state of the model
+
+// Functions for first predictor
+void StepModelSharded::Find_First_Predictor(arma::uword index) {
+
+  arma::uvec correlation_index = arma::sort_index(arma::abs(correlation_response), "descend");
+  first_index = index;
+  optimal_predictor = correlation_index(index);
+  beta_y_optimal = correlation_response(optimal_predictor);
+  Update_Z_Optimal();
+  residuals_new = y - beta_y_optimal*z_optimal;
+  Update_RSS();
+  Update_F_Value();
+  Update_P_Value();
+  // Check_Full();
+}
+
+// Function for finding optimal predictor (beyond first two predictors)
+// (the shards update their blocks of z with the z column of the added predictor)
+void StepModelSharded::Find_Optimal_Predictor() {
+
+  arma::uword first_column = (model_predictors.size() == 1) ? first_index : p;
+  if (!x.Update(model_id, first_column, z_optimal, optimal_predictor)) {
+    p_value = 1;
+    model_full = true;
+    return;
+  }
+  Update_Z_Optimal();
+  Update_Beta_Y_Optimal();
+  Update_Residuals();
+  Update_RSS();
+  Update_F_Value();
+  Update_P_Value();
+  Check_Full();
+}
+
+// Function to add optimal predictor to model
+void StepModelSharded::Add_Optimal_Predictor() {
+
+  if ((!Get_Full()) && (model_predictors.size()<n)) {
+    Add_Model_Predictor(optimal_predictor);
+    Remove_Available_Predictor(optimal_predictor);
+    residuals_old = residuals_new;
+    rss_old = rss_new;
+  }
+  else
+    model_full = true;
+}
+
+// Functions to add or remove a predictor
+void StepModelSharded::Add_Model_Predictor(arma::uword& predictor) {
+  model_predictors.push_back(predictor);
+}
+void StepModelSharded::Remove_Available_Predictor(arma::uword predictor) {
+
+  x.Remove(model_id, predictor);
+}
+void StepModelSharded::Remove_Available_Predictor_Update(arma::uword predictor) {
+
+  x.Remove(model_id, predictor);
+  if (!x.Optimal_Predictor(model_id, optimal_predictor)) {
+    p_value = 1;
+    model_full = true;
+    return;
+  }
+  Update_Z_Optimal();
+  Update_Beta_Y_Optimal();
+  Update_Residuals();
+  Update_RSS();
+  Update_F_Value();
+  Update_P_Value();
+  Check_Full();
+}
+
+// Functions to update model status
+void StepModelSharded::Update_Z_Optimal() {
+
+  z_optimal = x.Column(model_id, optimal_predictor);
+}
+void StepModelSharded::Update_Beta_Y_Optimal() {
+
+  beta_y_optimal = arma::dot(z_optimal, y) / arma::dot(z_optimal, z_optimal);
+}
+void StepModelSharded::Update_Residuals() {
+
+  residuals_new = residuals_old - beta_y_optimal * z_optimal;
+}
+void StepModelSharded::Update_RSS() {
+
+  rss_new = arma::as_scalar(residuals_new.t() * residuals_new);
+}
+void StepModelSharded::Update_F_Value() {
+
+  F_value = (rss_old - rss_new) / rss_new * (n - model_predictors.size() - 1);
+}
+void StepModelSharded::Update_P_Value() {
+
+  p_value = F_Upper_Tail(F_value, 1, n - model_predictors.size() - 1);
+}
+
+void StepModelSharded::Check_Full() {
+
+  if (p_value >= sig_level)
+    model_full = true;
+}
+
+// (+) Functions that return the state of the model
+bool StepModelSharded::Get_Full() {
+  return model_full;
+}
+
+double StepModelSharded::Get_F_Value() {
+  return F_value;
+}
+
+double StepModelSharded::Get_P_Value() {
+  return p_value;
+}
+
+arma::uword StepModelSharded::Get_Optimal_Predictor() {
+  return optimal_predictor;
+}
+
+std::vector<arma::uword> StepModelSharded::Get_Model_Predictors() {
+  return model_predictors;
+}
@@ -0,0 +1,320 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: StepModelSparse.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "StepModelSparse.hpp"
+#include "F_Distribution.hpp"
+#include "Binary_IO.hpp"
+
+// (+) Model Constructor
+
+StepModelSparse::StepModelSparse(Sparse_Design& x_design, arma::vec& y,
+                                 arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                 double& sig_level,
+                                 arma::uword n_threads) :
+  x(x_design.x), y(y),
+  correlation_predictors(correlation_predictors), correlation_response(correlation_response),
+  sig_level(sig_level), n_threads(n_threads) {
+
+  // Initialize dimension of data
+  n = x.n_rows;
+  p = x.n_cols;
+
+  // Initialize available predictors
+  for (arma::uword pred_id = 0; pred_id < p; pred_id++)
+    available_predictors.push_back(pred_id);
+
+  // Initialize partial correlations
+  partial_correlations = correlation_response;
+
+  // Initialize projections (z = x - 1 * center.t(), or z = x without centering)
+  if (arma::any(x_design.center != 0)) {
+    projection_directions = arma::ones(n, 1);
+    projection_coefficients = x_design.center;
+  }
+  else {
+    projection_directions.set_size(n, 0);
+    projection_coefficients.set_size(p, 0);
+  }
+  direction_new = arma::zeros(n);
+  coefficients_new = arma::zeros(p);
+  projection_pending = false;
+
+  // Initialize inner products of z with y and with itself (over the nonzero entries of x)
+  zy_old = x.t() * y;
+  zz_old = arma::zeros(p);
+  arma::vec x_sums = arma::zeros(p);
+  for (arma::sp_mat::const_iterator it = x.begin(); it != x.end(); ++it) {
+    zz_old(it.col()) += (*it) * (*it);
+    x_sums(it.col()) += (*it);
+  }
+  if (projection_directions.n_cols > 0) {
+    zy_old -= x_design.center * arma::accu(y);
+    zz_old += n * arma::square(x_design.center) - 2 * x_design.center % x_sums;
+  }
+  zy_new = zy_old;
+  zz_new = zz_old;
+
+  // Initialize residuals
+  residuals_old = residuals_new = y;
+  rss_old = rss_new = arma::as_scalar(y.t()*y);
+
+  // Initialize model saturation
+  model_full = false;
+}
+
+// (+) Functions that update the current state of the model
+
+// Functions for first predictor
+void StepModelSparse::Find_First_Predictor(arma::uword index) {
+
+  arma::uvec correlation_index = arma::sort_index(arma::abs(correlation_response), "descend");
+  first_index = index;
+  optimal_predictor = correlation_index(index);
+  beta_y_optimal = correlation_response(optimal_predictor);
+  residuals_new = y - beta_y_optimal*Z_Old_Column(optimal_predictor);
+  Update_RSS();
+  Update_F_Value();
+  Update_P_Value();
+  // Check_Full();
+}
+
+// Function for finding optimal predictor (beyond first two predictors)
+void StepModelSparse::Find_Optimal_Predictor() {
+
+  Update_Z_Matrix();
+  Update_Partial_Correlations();
+  Update_Optimal_Predictor();
+  Update_Beta_Y_Optimal();
+  Update_Residuals();
+  Update_RSS();
+  Update_F_Value();
+  Update_P_Value();
+  Check_Full();
+}
+
+// Function to add optimal predictor to model
+void StepModelSparse::Add_Optimal_Predictor() {
+
+  if ((!Get_Full()) && (model_predictors.size()<n)) {
+    Add_Model_Predictor(optimal_predictor);
+    Remove_Available_Predictor(optimal_predictor);
+    residuals_old = residuals_new;
+    rss_old = rss_new;
+    if (projection_pending) {
+      projection_directions.insert_cols(projection_directions.n_cols, direction_new);
+      projection_coefficients.insert_cols(projection_coefficients.n_cols, coefficients_new);
+      projection_pending = false;
+    }
+    zy_old = zy_new;
+    zz_old = zz_new;
+  }
+  else
+    model_full = true;
+}
+
+// Functions to add or remove a predictor
+void StepModelSparse::Add_Model_Predictor(arma::uword& predictor) {
+  model_predictors.push_back(predictor);
+}
+void StepModelSparse::Remove_Available_Predictor(arma::uword predictor) {
+
+  std::vector<arma::uword>::iterator drop_position = std::find(available_predictors.begin(), available_predictors.end(), predictor);
+  if (drop_position != available_predictors.end())
+    available_predictors.erase(drop_position);
+  partial_correlations(predictor) = 0;
+}
+void StepModelSparse::Remove_Available_Predictor_Update(arma::uword predictor) {
+
+  std::vector<arma::uword>::iterator drop_position = std::find(available_predictors.begin(), available_predictors.end(), predictor);
+  if (drop_position != available_predictors.end())
+    available_predictors.erase(drop_position);
+  partial_correlations(predictor) = 0;
+  Update_Optimal_Predictor();
+  Update_Beta_Y_Optimal();
+  Update_Residuals();
+  Update_RSS();
+  Update_F_Value();
+  Update_P_Value();
+  Check_Full();
+}
+
+// Function to update z matrix (only the new projection and the inner products are computed)
+void StepModelSparse::Update_Z_Matrix() {
+
+  direction_new = Z_Old_Column(optimal_predictor);
+  double direction_norm = arma::dot(direction_new, direction_new);
+
+  // Inner products of the columns of x with the new direction (over the nonzero entries)
+  arma::vec z_direction(p);
+  const double* x_values = x.values;
+  const arma::uword* x_rows = x.row_indices;
+  const arma::uword* x_cols = x.col_ptrs;
+#pragma omp parallel for schedule(static) num_threads(n_threads)
+  for (arma::uword pred_id = 0; pred_id < p; pred_id++) {
+    double x_direction = 0;
+    for (arma::uword nz_id = x_cols[pred_id]; nz_id < x_cols[pred_id + 1]; nz_id++)
+      x_direction += x_values[nz_id] * direction_new(x_rows[nz_id]);
+    z_direction(pred_id) = x_direction;
+  }
+  if (projection_directions.n_cols > 0)
+    z_direction -= projection_coefficients * (projection_directions.t() * direction_new);
+
+  if (model_predictors.size() == 1)
+    coefficients_new = correlation_predictors.col(first_index);
+  else
+    coefficients_new = z_direction / direction_norm;
+  projection_pending = true;
+
+  zy_new = zy_old - coefficients_new * arma::dot(direction_new, y);
+  zz_new = zz_old - 2 * coefficients_new % z_direction + arma::square(coefficients_new) * direction_norm;
+}
+arma::vec StepModelSparse::X_Column(arma::uword predictor) {
+
+  arma::vec x_column = arma::zeros(n);
+  for (arma::sp_mat::const_col_iterator it = x.begin_col(predictor); it != x.end_col(predictor); ++it)
+    x_column(it.row()) = *it;
+  return x_column;
+}
+arma::vec StepModelSparse::Z_Old_Column(arma::uword predictor) {
+
+  arma::vec z_column = X_Column(predictor);
+  if (projection_directions.n_cols > 0)
+    z_column -= projection_directions * projection_coefficients.row(predictor).t();
+  return z_column;
+}
+arma::vec StepModelSparse::Z_New_Column(arma::uword predictor) {
+
+  arma::vec z_column = Z_Old_Column(predictor);
+  if (projection_pending)
+    z_column -= coefficients_new(predictor) * direction_new;
+  return z_column;
+}
+
+// Functions to update model status
+void StepModelSparse::Update_Partial_Correlations() {
+
+  begin_iterator = available_predictors.begin();
+  end_iterator = begin_iterator + available_predictors.size();
+  for (auto pred_id = begin_iterator; pred_id != end_iterator; pred_id++) {
+    partial_correlations(*pred_id) = (zz_new(*pred_id) > 0) ?
+      zy_new(*pred_id) / zz_new(*pred_id) / std::sqrt(n) : 0;
+  }
+}
+void StepModelSparse::Update_Optimal_Predictor() {
+
+  optimal_predictor = arma::abs(partial_correlations).index_max();
+}
+void StepModelSparse::Update_Beta_Y_Optimal() {
+
+  beta_y_optimal = zy_new(optimal_predictor) / zz_new(optimal_predictor);
+}
+void StepModelSparse::Update_Residuals() {
+
+  residuals_new = residuals_old - beta_y_optimal * Z_New_Column(optimal_predictor);
+}
+void StepModelSparse::Update_RSS() {
+
+  rss_new = arma::as_scalar(residuals_new.t() * residuals_new);
+}
+void StepModelSparse::Update_F_Value() {
+
+  F_value = (rss_old - rss_new) / rss_new * (n - model_predictors.size() - 1);
+}
+void StepModelSparse::Update_P_Value() {
+
+  p_value = F_Upper_Tail(F_value, 1, n - model_predictors.size() - 1);
+}
+
+void StepModelSparse::Check_Full() {
+
+  if (p_value >= sig_level)
+    model_full = true;
+}
+
+// (+) Functions to checkpoint the state of the model
+void StepModelSparse::Save_State(std::ostream& out) {
+
+  Write_Integer(out, n);
+  Write_Integer(out, p);
+  Write_Indices(out, model_predictors);
+  Write_Indices(out, available_predictors);
+  Write_Matrix(out, partial_correlations);
+  Write_Matrix(out, projection_directions);
+  Write_Matrix(out, projection_coefficients);
+  Write_Matrix(out, direction_new);
+  Write_Matrix(out, coefficients_new);
+  Write_Matrix(out, zy_old);
+  Write_Matrix(out, zy_new);
+  Write_Matrix(out, zz_old);
+  Write_Matrix(out, zz_new);
+  Write_Matrix(out, residuals_old);
+  Write_Matrix(out, residuals_new);
+  Write_Integer(out, optimal_predictor);
+  Write_Integer(out, first_index);
+  Write_Real(out, beta_y_optimal);
+  Write_Real(out, rss_old);
+  Write_Real(out, rss_new);
+  Write_Real(out, F_value);
+  Write_Real(out, p_value);
+  Write_Integer(out, projection_pending);
+  Write_Integer(out, model_full);
+}
+void StepModelSparse::Load_State(std::istream& in) {
+
+  if ((Read_Integer(in) != n) || (Read_Integer(in) != p))
+    throw std::runtime_error("checkpoint does not match the dimensions of the data");
+  model_predictors = Read_Indices(in, p, p);
+  available_predictors = Read_Indices(in, p, p);
+  partial_correlations = Read_Vector(in, p);
+  projection_directions = Read_Matrix(in, n, p + 1);
+  projection_coefficients = Read_Matrix(in, p, p + 1);
+  if (projection_coefficients.n_cols != projection_directions.n_cols)
+    throw std::runtime_error("corrupt checkpoint file");
+  direction_new = Read_Vector(in, n);
+  coefficients_new = Read_Vector(in, p);
+  zy_old = Read_Vector(in, p);
+  zy_new = Read_Vector(in, p);
+  zz_old = Read_Vector(in, p);
+  zz_new = Read_Vector(in, p);
+  residuals_old = Read_Vector(in, n);
+  residuals_new = Read_Vector(in, n);
+  optimal_predictor = Read_Index(in, p);
+  first_index = Read_Index(in, correlation_predictors.n_cols);
+  beta_y_optimal = Read_Real(in);
+  rss_old = Read_Real(in);
+  rss_new = Read_Real(in);
+  F_value = Read_Real(in);
+  p_value = Read_Real(in);
+  projection_pending = (Read_Integer(in) != 0);
+  model_full = (Read_Integer(in) != 0);
+}
+
+// (+) Functions that return the state of the model
+bool StepModelSparse::Get_Full() {
+  return model_full;
+}
+
+double StepModelSparse::Get_F_Value() {
+  return F_value;
+}
+
+double StepModelSparse::Get_P_Value() {
+  return p_value;
+}
+
+arma::uword StepModelSparse::Get_Optimal_Predictor() {
+  return optimal_predictor;
+}
+
+std::vector<arma::uword> StepModelSparse::Get_Model_Predictors() {
+  return model_predictors;
+}
@@ -18,7 +18,8 @@ std::vector<arma::uword> Robust_Stepwise(arma::mat& x, arma::vec& y,
                                          arma::mat& correlation_predictors, arma::vec& correlation_response,
                                          arma::uword& model_saturation,
                                          double& sig_level,
-                                         arma::uword& model_size) {
+                                         arma::uword& model_size,
+                                         arma::uword n_threads = 1) {
   
   // Case with p-value
   if(model_saturation==0){
@@ -26,7 +27,7 @@ std::vector<arma::uword> Robust_Stepwise(arma::mat& x, arma::vec& y,
     // Create the stepwise model
     StepModel model(x, y,
                     correlation_predictors, correlation_response, 
-                    sig_level);
+                    sig_level, n_threads);
     
     // Initialize the model through the constructor and add first predictor
     model.Find_First_Predictor(0);
@@ -60,7 +61,7 @@ std::vector<arma::uword> Robust_Stepwise(arma::mat& x, arma::vec& y,
     // Create the stepwise model
     StepModelFixed model(x, y,
                          correlation_predictors, correlation_response, 
-                         model_size);
+                         model_size, n_threads);
     
     // Initialize the model through the constructor and add first predictor
     model.Find_First_Predictor(0);
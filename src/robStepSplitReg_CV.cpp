@@ -0,0 +1,141 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: robStepSplitReg_CV.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "Split_Models.hpp"
+#include "Ensemble_Prediction.hpp"
+
+// Libraries included
+#include <exception>
+#include <stdexcept>
+
+// OpenMP for the fold-level parallelism
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Cross-validation of the robust stepwise split over a grid of tuning parameters
+// - folds: fold of each observation (0, ..., n_folds - 1)
+// - correlation_predictors_folds (p x max(n_models_grid) x n_folds) and correlation_response_folds (p x n_folds):
+//   correlations computed on the training rows of each fold (the correlations pick the first predictors and
+//   their projections, so correlations that see the held-out rows would bias the prediction error downwards);
+//   slice fold holds the columns for the max(n_models_grid) predictors most correlated with the response on
+//   the training rows, in decreasing order, as the fits on row views expect
+// - The fits run on row views of x, so no copy of the training or test rows is made per fold
+// - sig_level_grid or model_size_grid is used depending on model_saturation
+// - n_threads: number of threads (0 uses all available cores)
+// [[Rcpp::export]]
+Rcpp::List Robust_Stepwise_Split_CV(arma::mat& x, arma::vec& y,
+                                    arma::cube& correlation_predictors_folds, arma::mat& correlation_response_folds,
+                                    arma::uword& model_saturation,
+                                    arma::vec& sig_level_grid,
+                                    arma::uvec& model_size_grid,
+                                    arma::uvec& n_models_grid,
+                                    arma::uvec& folds,
+                                    arma::uword& n_folds,
+                                    arma::uword& n_threads){
+
+  // Size of the tuning grid
+  arma::uword n_tuning = (model_saturation == 0) ? sig_level_grid.n_elem : model_size_grid.n_elem;
+  arma::uword n_grid = n_models_grid.n_elem * n_tuning;
+
+  // Folds of the observations (every fold holds some but not all of the observations)
+  if ((folds.n_elem != x.n_rows) || arma::any(folds >= n_folds))
+    throw std::runtime_error("folds must assign each observation to one of the n_folds folds");
+  std::vector<arma::uvec> train_rows(n_folds), test_rows(n_folds);
+  for (arma::uword fold = 0; fold < n_folds; fold++) {
+    train_rows[fold] = arma::find(folds != fold);
+    test_rows[fold] = arma::find(folds == fold);
+    if (train_rows[fold].is_empty() || test_rows[fold].is_empty())
+      throw std::runtime_error("every fold must hold some but not all of the observations");
+  }
+
+  // Correlations of the training rows of each fold
+  arma::uword max_models = n_models_grid.is_empty() ? 0 : arma::max(n_models_grid);
+  if ((correlation_predictors_folds.n_rows != x.n_cols) || (correlation_predictors_folds.n_cols < max_models) ||
+      (correlation_predictors_folds.n_slices != n_folds) ||
+      (correlation_response_folds.n_rows != x.n_cols) || (correlation_response_folds.n_cols != n_folds))
+    throw std::runtime_error("the correlations must be supplied for each fold (p x max(n_models_grid) x n_folds and p x n_folds)");
+
+  // Number of threads
+#ifdef _OPENMP
+  if (n_threads == 0)
+    n_threads = omp_get_num_procs();
+#endif
+
+  // Training and test responses for each fold (shared by all fits of the fold)
+  std::vector<arma::vec> y_train(n_folds), y_test(n_folds);
+  std::vector<arma::vec> correlation_response_train(n_folds);
+  for (arma::uword fold = 0; fold < n_folds; fold++) {
+
+    y_train[fold] = y.elem(train_rows[fold]);
+    y_test[fold] = y.elem(test_rows[fold]);
+    correlation_response_train[fold] = correlation_response_folds.col(fold);
+  }
+
+  // Prediction error for each grid point and fold
+  arma::cube cv_error_folds = arma::zeros<arma::cube>(n_models_grid.n_elem, n_tuning, n_folds);
+
+  // Fit the ensembles of all folds and grid points concurrently
+  // (the rows, responses and correlations of a fold are shared by the fits of its grid points)
+  std::exception_ptr task_exception = nullptr;
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+  for (arma::uword task = 0; task < n_folds * n_grid; task++) {
+    try {
+      // Fold and grid point of the task
+      arma::uword fold = task / n_grid;
+      arma::uword models_id = (task % n_grid) / n_tuning;
+      arma::uword tuning_id = task % n_tuning;
+
+      // Tuning parameters of the task
+      arma::uword n_models = n_models_grid(models_id);
+      double sig_level = (model_saturation == 0) ? sig_level_grid(tuning_id) : 0;
+      arma::uword model_size = (model_saturation == 0) ? 0 : model_size_grid(tuning_id);
+
+      // Training and test rows of the fold
+      Row_View x_train(x, train_rows[fold]);
+      Row_View x_test(x, test_rows[fold]);
+
+      // Split the predictors on the training data
+      std::vector<std::vector<arma::uword>> final_predictors = Split_Models(x_train, y_train[fold],
+                                                                            correlation_predictors_folds.slice(fold),
+                                                                            correlation_response_train[fold],
+                                                                            model_saturation,
+                                                                            sig_level,
+                                                                            model_size,
+                                                                            n_models);
+
+      // Prediction error on the test data
+      std::vector<arma::vec> coefficients = Ensemble_Coefficients(x_train, y_train[fold], final_predictors);
+      arma::vec predictions = Ensemble_Predictions(x_test, final_predictors, coefficients);
+      cv_error_folds(models_id, tuning_id, fold) = arma::mean(arma::square(y_test[fold] - predictions));
+    } catch (...) {
+#pragma omp critical
+      {
+        if (!task_exception)
+          task_exception = std::current_exception();
+      }
+    }
+  }
+
+  // Exceptions of the fits are raised on the calling thread (they cannot leave the parallel region)
+  if (task_exception)
+    std::rethrow_exception(task_exception);
+
+  // Average prediction error over the folds
+  arma::mat cv_error = arma::zeros(n_models_grid.n_elem, n_tuning);
+  for (arma::uword fold = 0; fold < n_folds; fold++)
+    cv_error += cv_error_folds.slice(fold);
+  cv_error /= n_folds;
+
+  return Rcpp::List::create(Rcpp::Named("cv_error") = cv_error,
+                            Rcpp::Named("cv_error_folds") = cv_error_folds);
+}
@@ -0,0 +1,66 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: robStepSplitReg_IO.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "Ensemble_Prediction.hpp"
+#include "Ensemble_Binary.hpp"
+
+// Save the fitted ensemble (predictors in each model, least squares coefficients and fit path) to a binary file
+// - final_predictors: list with the predictors in each model (as returned by Robust_Stepwise_Split)
+// - path_models, path_predictors: fit path (empty if not recorded)
+// [[Rcpp::export]]
+void Save_Ensemble(std::string file,
+                   arma::mat& x, arma::vec& y,
+                   Rcpp::List& final_predictors_list,
+                   std::vector<arma::uword> path_models,
+                   std::vector<arma::uword> path_predictors){
+
+  std::vector<std::vector<arma::uword>> final_predictors;
+  for (arma::uword m = 0; m < (arma::uword) final_predictors_list.size(); m++)
+    final_predictors.push_back(Rcpp::as<std::vector<arma::uword>>(final_predictors_list[m]));
+  std::vector<arma::vec> coefficients = Ensemble_Coefficients(x, y, final_predictors);
+
+  Write_Ensemble(file, final_predictors, coefficients, path_models, path_predictors);
+}
+
+// Load the fitted ensemble from a binary file
+// [[Rcpp::export]]
+Rcpp::List Load_Ensemble(std::string file){
+
+  Ensemble_Map ensemble_map(file);
+  Ensemble_View ensemble = ensemble_map.Get_View();
+
+  arma::uword n_models = ensemble.Get_N_Models();
+  Rcpp::List final_predictors_list(n_models), coefficients_list(n_models);
+  for (arma::uword m = 0; m < n_models; m++) {
+
+    arma::uword n_predictors = ensemble.Get_N_Predictors(m);
+    const std::uint64_t* predictors = ensemble.Get_Predictors(m);
+    final_predictors_list[m] = std::vector<arma::uword>(predictors, predictors + n_predictors);
+    coefficients_list[m] = arma::vec(ensemble.Get_Coefficients(m), n_predictors + 1);
+  }
+  arma::uword path_length = ensemble.Get_Path_Length();
+  std::vector<arma::uword> path_models(ensemble.Get_Path_Models(), ensemble.Get_Path_Models() + path_length);
+  std::vector<arma::uword> path_predictors(ensemble.Get_Path_Predictors(), ensemble.Get_Path_Predictors() + path_length);
+
+  return Rcpp::List::create(Rcpp::Named("predictors") = final_predictors_list,
+                            Rcpp::Named("coefficients") = coefficients_list,
+                            Rcpp::Named("path_models") = path_models,
+                            Rcpp::Named("path_predictors") = path_predictors);
+}
+
+// Predictions of the ensemble in a binary file (the file is mapped and used in place)
+// [[Rcpp::export]]
+arma::vec Predict_Ensemble(std::string file, arma::mat& x_new){
+
+  Ensemble_Map ensemble_map(file);
+  return ensemble_map.Get_View().Predict(x_new);
+}
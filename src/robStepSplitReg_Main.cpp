@@ -10,169 +10,272 @@
  */
 
 // Header files included
-#include "StepModel.hpp"
-#include "StepModelFixed.hpp"
+#include "Split_Models.hpp"
+#include "Screening.hpp"
 #include "Generate_Predictors_List.hpp"
 
+// Libraries included
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+// - screen_size: number of predictors most correlated with the response in the working set of the
+//   search (0 searches all the predictors); the working set is expanded until the result matches
+//   the search on all the predictors
+// - batched: in each round every unsaturated model proposes its candidate, conflicts are resolved by
+//   p-value and the winning additions are applied together (n_threads then updates models in parallel)
+// - checkpoint_file: state of the split is saved at most every checkpoint_interval seconds, and an
+//   interrupted split resumes from the file if it exists ("" disables checkpoints; the file is removed
+//   on completion)
+// - Checkpoints are not supported with screening (0 < screen_size < p): the working set changes between
+//   the splits on it, so a checkpoint_file with such a screen_size is rejected
+// - A checkpoint holds the z matrix of every model, so it takes about 8 * n_models * n * p bytes
+//   (written through a temporary file of the same size); the interval should leave the writes
+//   negligible next to the steps of the split
+// - return_path: the list also holds the fit path (models and predictors in order of addition)
 // [[Rcpp::export]]
 Rcpp::List Robust_Stepwise_Split(arma::mat& x, arma::vec& y,
                                  arma::mat& correlation_predictors, arma::vec& correlation_response,
                                  arma::uword& model_saturation,
                                  double& sig_level,
                                  arma::uword& model_size,
-                                 arma::uword& n_models){
-  // Case with p-value
-  if(model_saturation==0){
-    
-    // Create the memory for the models (through dynamic allocation)
-    std::vector<StepModel*> models;
-    
-    // Initialize the models through the constructors and add first predictor
-    for (arma::uword m = 0; m < n_models; m++) {
-      
-      models.push_back(new StepModel(x, y, correlation_predictors, correlation_response, sig_level));
-      models[m]->Find_First_Predictor(m);
-      models[m]->Add_Optimal_Predictor();
-    }
-    
-    // Remove initial predictors already used
-    for  (arma::uword m = 0; m < n_models; m++)
-      for (arma::uword r = 0; r < n_models; r++){
-        if(r != m)
-          models[m]->Remove_Available_Predictor(models[r]->Get_Optimal_Predictor());
-      }
-        
-    // Variables for model updates
-    arma::vec p_values = arma::ones(n_models);
-    arma::uword optimal_model;
-    arma::uword n_pred = 0;
-    for (arma::uword m = 0; m < n_models; m++) {
-      
-      p_values(m) = models[m]->Get_P_Value();
-      if (!(models[m]->Get_Full()))
-        n_pred++;
-    }
-    
-    // Find optimal predictor for unsaturated models
-    for (arma::uword m = 0; m < n_models; m++){
-      if (!models[m]->Get_Full()) {
-        models[m]->Find_Optimal_Predictor();
-        p_values[m] = models[m]->Get_P_Value();
-      }
-    }
-    
-    // Looping and adding predictors
-    while (n_pred < x.n_cols) {
-      
-      // Find optimal model for update
-      optimal_model = p_values.index_min();
-      
-      // Add optimal predictor
-      if (models[optimal_model]->Get_P_Value() < sig_level) {
-        models[optimal_model]->Add_Optimal_Predictor();
-        n_pred++;
-      }
-      else
-        break; // Update for optimal model is not statistically significant
-      
-      // Remove optimal predictor for non-optimal models
-      for (arma::uword m = 0; m < n_models; m++){
-        if ((!models[m]->Get_Full()) && (m != optimal_model))
-          models[m]->Remove_Available_Predictor_Update(models[optimal_model]->Get_Optimal_Predictor());
-      }
-      
-      // Update partial correlations for optimal model
-      models[optimal_model]->Find_Optimal_Predictor();
-      
-      // Update p-values
-      for (arma::uword m = 0; m < n_models; m++){
-        if (!models[m]->Get_Full()) 
-          p_values[m] = models[m]->Get_P_Value();
-      }
-    }
-    
-    // List with variables in each model
-    Rcpp::List final_predictors_list = Generate_Predictors_List(models, n_models);
-    
-    // Delete the models
-    for (arma::uword m = 0; m < n_models; m++)
-      delete(models[m]);
-    
-    return final_predictors_list;
-  } 
-  else{ // Case with fixed model size
-    
-    // Create the memory for the models (through dynamic allocation)
-    std::vector<StepModelFixed*> models;
-    
-    // Initialize the models through the constructors and add first predictor
-    for (arma::uword m = 0; m < n_models; m++) {
-      
-      models.push_back(new StepModelFixed(x, y, correlation_predictors, correlation_response, model_size));
-      models[m]->Find_First_Predictor(m);
-      models[m]->Add_Optimal_Predictor();
-    }
-    
-    // Remove initial predictors already used
-    for  (arma::uword m = 0; m < n_models; m++)
-      for (arma::uword r = 0; r < n_models; r++)
-        if(r != m)
-          models[m]->Remove_Available_Predictor(models[r]->Get_Optimal_Predictor());
-        
-    // Variables for model updates
-    arma::vec p_values = arma::ones(n_models);
-    arma::uword optimal_model;
-    arma::uword full_models = 0; 
-    arma::uword n_pred = 0;
-    for (arma::uword m = 0; m < n_models; m++) {
-      
-      if (!(models[m]->Get_Full()))
-        n_pred++;
-      else
-        full_models++;
-    }
-    
-    // Find optimal predictor for unsaturated models
-    for (arma::uword m = 0; m < n_models; m++){
-      if (!models[m]->Get_Full()) {
-        models[m]->Find_Optimal_Predictor();
-        p_values[m] = models[m]->Get_P_Value();
-      }
-    }
+                                 arma::uword& n_models,
+                                 arma::uword n_threads = 1,
+                                 arma::uword screen_size = 0,
+                                 bool batched = false,
+                                 std::string checkpoint_file = "",
+                                 double checkpoint_interval = 600,
+                                 bool return_path = false){
+  
+  // Checkpoints need the split on all the predictors
+  if ((screen_size > 0) && (screen_size < x.n_cols) && !checkpoint_file.empty())
+    throw std::runtime_error("checkpoints are not supported with screening (screen_size must be 0 or at least p)");
+  
+  // Run the split algorithm
+  Split_Trace trace;
+  Split_Checkpoint checkpoint = {checkpoint_file, checkpoint_interval, std::chrono::steady_clock::now(), Split_Fingerprint()};
+  checkpoint.fingerprint.screen_size = screen_size;
+  std::vector<std::vector<arma::uword>> final_predictors = Split_Models_Screened(x, y,
+                                                                                 correlation_predictors, correlation_response,
+                                                                                 model_saturation,
+                                                                                 sig_level,
+                                                                                 model_size,
+                                                                                 n_models,
+                                                                                 screen_size,
+                                                                                 n_threads,
+                                                                                 batched,
+                                                                                 &trace,
+                                                                                 &checkpoint);
+  
+  // Checkpoint of a completed split is discarded
+  if (!checkpoint_file.empty())
+    std::remove(checkpoint_file.c_str());
+  
+  // List with variables in each model
+  if (return_path)
+    return Rcpp::List::create(Rcpp::Named("predictors") = Generate_Predictors_List(final_predictors, n_models),
+                              Rcpp::Named("path_models") = trace.path_models,
+                              Rcpp::Named("path_predictors") = trace.path_predictors);
+  return Generate_Predictors_List(final_predictors, n_models);
+}
 
-    // Looping and adding predictors
-    while ((n_pred < x.n_cols) && (full_models < n_models)) {
-      
-      // Find optimal model for update
-      optimal_model = p_values.index_min();
-      
-      // Add optimal predictor
-      if (!(models[optimal_model]->Get_Full())) {
-        models[optimal_model]->Add_Optimal_Predictor();
-        n_pred++;
-        
-        // Remove optimal predictor for non-optimal models
-        for (arma::uword m = 0; m < n_models; m++){
-          if ((!models[m]->Get_Full()) && (m != optimal_model))
-            models[m]->Remove_Available_Predictor_Update(models[optimal_model]->Get_Optimal_Predictor());
-        }
-        
-        // Update partial correlations for optimal model 
-        models[optimal_model]->Find_Optimal_Predictor();
-      } 
-      else{
-        full_models++;
-        p_values[optimal_model] = 2; 
-      }
-    }
-    
-    // List with variables in each model
-    Rcpp::List final_predictors_list = Generate_Predictors_List_Fixed(models, n_models);
-    
-    // Delete the models
-    for (arma::uword m = 0; m < n_models; m++)
-      delete(models[m]);
+// Split for a sparse design matrix (dgCMatrix)
+// - column_center, column_scale: location and scale of each column of x (as used to standardize the dense
+//   design); the split runs on (x - 1 * column_center.t()) * diag(1 / column_scale) as the dense engine
+//   does on its standardized columns, with the scaling applied to the nonzero values and the centering
+//   applied implicitly, so x is never densified (empty vectors leave x uncentered or unscaled)
+// - correlation_predictors: columns of the correlation matrix for the n_models predictors with the
+//   largest absolute correlations with the response, in decreasing order (p x n_models)
+// - checkpoint_file, checkpoint_interval: as for the dense design matrix; a checkpoint holds the projections
+//   of every model instead of a z matrix, so it takes about 8 * n_models * (n + p) bytes per predictor added
+// [[Rcpp::export]]
+Rcpp::List Robust_Stepwise_Split_Sparse(arma::sp_mat x, arma::vec& y,
+                                        arma::vec column_center, arma::vec column_scale,
+                                        arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                        arma::uword& model_saturation,
+                                        double& sig_level,
+                                        arma::uword& model_size,
+                                        arma::uword& n_models,
+                                        arma::uword n_threads = 1,
+                                        bool batched = false,
+                                        std::string checkpoint_file = "",
+                                        double checkpoint_interval = 600){
+  
+  // Standardization of the columns (the scaling keeps the sparsity; the centers are in the scaled units)
+  if ((!column_center.is_empty() && (column_center.n_elem != x.n_cols)) ||
+      (!column_scale.is_empty() && (column_scale.n_elem != x.n_cols)))
+    throw std::runtime_error("column_center and column_scale must have one value per column of x");
+  if (!column_scale.is_empty()) {
+    if (arma::any(column_scale <= 0))
+      throw std::runtime_error("column_scale must be positive");
+    arma::sp_mat scaling = arma::speye(x.n_cols, x.n_cols);
+    scaling.diag() = 1 / column_scale;
+    x = x * scaling;
+    if (!column_center.is_empty())
+      column_center /= column_scale;
+  }
+  
+  // Run the split algorithm
+  Split_Checkpoint checkpoint = {checkpoint_file, checkpoint_interval, std::chrono::steady_clock::now(), Split_Fingerprint()};
+  std::vector<std::vector<arma::uword>> final_predictors = Split_Models_Sparse(x, y, column_center,
+                                                                               correlation_predictors, correlation_response,
+                                                                               model_saturation,
+                                                                               sig_level,
+                                                                               model_size,
+                                                                               n_models,
+                                                                               n_threads,
+                                                                               batched,
+                                                                               nullptr,
+                                                                               &checkpoint);
+  
+  // Checkpoint of a completed split is discarded
+  if (!checkpoint_file.empty())
+    std::remove(checkpoint_file.c_str());
+  
+  // List with variables in each model
+  return Generate_Predictors_List(final_predictors, n_models);
+}
+
+// Split with the predictors sharded across worker processes (for p too large for the z matrices of one process)
+// - n_shards: number of worker processes, each owning a contiguous block of predictors
+// - transport: "socket" (Unix domain sockets) or "shared_memory" (process-shared slots)
+// - correlation_predictors: columns of the correlation matrix for the n_models predictors with the
+//   largest absolute correlations with the response, in decreasing order (p x n_models)
+// [[Rcpp::export]]
+Rcpp::List Robust_Stepwise_Split_Sharded(arma::mat& x, arma::vec& y,
+                                         arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                         arma::uword& model_saturation,
+                                         double& sig_level,
+                                         arma::uword& model_size,
+                                         arma::uword& n_models,
+                                         arma::uword n_shards,
+                                         std::string transport = "socket",
+                                         bool batched = false){
+  
+  // Run the split algorithm
+  std::vector<std::vector<arma::uword>> final_predictors = Split_Models_Sharded(x, y,
+                                                                                correlation_predictors, correlation_response,
+                                                                                model_saturation,
+                                                                                sig_level,
+                                                                                model_size,
+                                                                                n_models,
+                                                                                n_shards,
+                                                                                transport,
+                                                                                batched);
+  
+  // List with variables in each model
+  return Generate_Predictors_List(final_predictors, n_models);
+}
+
+// Check of the sharded split against the split in one process on the same inputs
+// - correlation_predictors: full correlation matrix of the predictors (p x p); the sharded split gets its
+//   columns for the n_models predictors with the largest absolute correlations with the response
+// - model_match: whether each model has the same predictors, added in the same order, in the two splits
+// - match: whether all the models match
+// [[Rcpp::export]]
+Rcpp::List Robust_Stepwise_Split_Sharded_Check(arma::mat& x, arma::vec& y,
+                                               arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                               arma::uword& model_saturation,
+                                               double& sig_level,
+                                               arma::uword& model_size,
+                                               arma::uword& n_models,
+                                               arma::uword n_shards,
+                                               std::string transport = "socket",
+                                               bool batched = false){
+  
+  // Split in one process
+  std::vector<std::vector<arma::uword>> single_predictors = Split_Models(x, y,
+                                                                         correlation_predictors, correlation_response,
+                                                                         model_saturation,
+                                                                         sig_level,
+                                                                         model_size,
+                                                                         n_models,
+                                                                         1,
+                                                                         batched);
+  
+  // Sharded split (with the columns of the correlation matrix for the first predictors of the models)
+  arma::uvec correlation_index = arma::sort_index(arma::abs(correlation_response), "descend");
+  arma::mat correlation_predictors_first = correlation_predictors.cols(correlation_index.head(n_models));
+  std::vector<std::vector<arma::uword>> sharded_predictors = Split_Models_Sharded(x, y,
+                                                                                  correlation_predictors_first, correlation_response,
+                                                                                  model_saturation,
+                                                                                  sig_level,
+                                                                                  model_size,
+                                                                                  n_models,
+                                                                                  n_shards,
+                                                                                  transport,
+                                                                                  batched);
+  
+  // Comparison of the models
+  std::vector<bool> model_match(n_models);
+  for (arma::uword m = 0; m < n_models; m++)
+    model_match[m] = (single_predictors[m] == sharded_predictors[m]);
+  bool match = (std::find(model_match.begin(), model_match.end(), false) == model_match.end());
+  
+  return Rcpp::List::create(Rcpp::Named("single") = Generate_Predictors_List(single_predictors, n_models),
+                            Rcpp::Named("sharded") = Generate_Predictors_List(sharded_predictors, n_models),
+                            Rcpp::Named("model_match") = model_match,
+                            Rcpp::Named("match") = match);
+}
+
+// Comparison of the batched rounds with the sequential split
+// - model_drift: size of the symmetric difference between the predictors of each model in the two splits
+// - drift: proportion of the predictors not assigned to the same model in the two splits
+// [[Rcpp::export]]
+Rcpp::List Robust_Stepwise_Split_Drift(arma::mat& x, arma::vec& y,
+                                       arma::mat& correlation_predictors, arma::vec& correlation_response,
+                                       arma::uword& model_saturation,
+                                       double& sig_level,
+                                       arma::uword& model_size,
+                                       arma::uword& n_models,
+                                       arma::uword n_threads = 1){
+  
+  // Sequential split
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  std::vector<std::vector<arma::uword>> sequential_predictors = Split_Models(x, y,
+                                                                             correlation_predictors, correlation_response,
+                                                                             model_saturation,
+                                                                             sig_level,
+                                                                             model_size,
+                                                                             n_models,
+                                                                             n_threads,
+                                                                             false);
+  double time_sequential = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  
+  // Batched split
+  start_time = std::chrono::steady_clock::now();
+  std::vector<std::vector<arma::uword>> batched_predictors = Split_Models(x, y,
+                                                                          correlation_predictors, correlation_response,
+                                                                          model_saturation,
+                                                                          sig_level,
+                                                                          model_size,
+                                                                          n_models,
+                                                                          n_threads,
+                                                                          true);
+  double time_batched = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+  
+  // Drift of the batched split from the sequential split
+  arma::uvec model_drift(n_models);
+  arma::uword n_sequential = 0, n_batched = 0, n_matching = 0;
+  for (arma::uword m = 0; m < n_models; m++) {
     
-    return final_predictors_list;
+    arma::uword model_matching = 0;
+    for (arma::uword pred_id = 0; pred_id < batched_predictors[m].size(); pred_id++)
+      if (std::find(sequential_predictors[m].begin(), sequential_predictors[m].end(), batched_predictors[m][pred_id]) != sequential_predictors[m].end())
+        model_matching++;
+    model_drift(m) = sequential_predictors[m].size() + batched_predictors[m].size() - 2 * model_matching;
+    n_sequential += sequential_predictors[m].size();
+    n_batched += batched_predictors[m].size();
+    n_matching += model_matching;
   }
+  double drift = 1 - (double) n_matching / std::max(n_sequential, n_batched);
+  
+  return Rcpp::List::create(Rcpp::Named("sequential") = Generate_Predictors_List(sequential_predictors, n_models),
+                            Rcpp::Named("batched") = Generate_Predictors_List(batched_predictors, n_models),
+                            Rcpp::Named("model_drift") = model_drift,
+                            Rcpp::Named("drift") = drift,
+                            Rcpp::Named("time_sequential") = time_sequential,
+                            Rcpp::Named("time_batched") = time_batched);
 }
\ No newline at end of file
@@ -0,0 +1,290 @@
+/*
+ * ===========================================================
+ * File Type: CPP
+ * File Name: robStepSplitReg_Stability.cpp
+ * Package Name: robStepSplitReg
+ *
+ * Created by Anthony-A. Christidis.
+ * Copyright (c) Anthony-A. Christidis. All rights reserved.
+ * ===========================================================
+ */
+
+// Header files included
+#include "Split_Models.hpp"
+
+// Libraries included
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <random>
+#include <vector>
+
+// OpenMP for the subsample-level parallelism
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Rows of the subsample b (sorted, so the rows are gathered in memory order)
+// - Without replacement: subsample_size rows; with replacement (bootstrap): n rows
+// - The generator of each subsample is seeded by (seed, b), so the result does not depend on the threads
+arma::uvec Subsample_Rows(arma::uword n, arma::uword subsample_size, bool bootstrap,
+                          arma::uword seed, arma::uword b) {
+
+  std::seed_seq seeds{(unsigned long long) seed, (unsigned long long) b};
+  std::mt19937_64 generator(seeds);
+
+  arma::uvec rows;
+  if (bootstrap) {
+    std::uniform_int_distribution<arma::uword> row_distribution(0, n - 1);
+    rows.set_size(n);
+    for (arma::uword i = 0; i < n; i++)
+      rows(i) = row_distribution(generator);
+  }
+  else {
+    // Partial Fisher-Yates shuffle
+    arma::uvec shuffle = arma::regspace<arma::uvec>(0, n - 1);
+    for (arma::uword i = 0; i < subsample_size; i++) {
+      std::uniform_int_distribution<arma::uword> row_distribution(i, n - 1);
+      std::swap(shuffle(i), shuffle(row_distribution(generator)));
+    }
+    rows = shuffle.head(subsample_size);
+  }
+
+  return arma::sort(rows);
+}
+
+// Standardized ranks of v (centered, unit norm), with average ranks for ties
+// - A constant vector has zero ranks, so its correlations are zero
+arma::vec Standardized_Ranks(arma::vec& v) {
+
+  arma::uword n = v.n_elem;
+  arma::uvec order = arma::sort_index(v);
+  arma::vec ranks(n);
+  for (arma::uword i = 0; i < n; ) {
+    arma::uword j = i;
+    while ((j + 1 < n) && (v(order(j + 1)) == v(order(i))))
+      j++;
+    for (arma::uword k = i; k <= j; k++)
+      ranks(order(k)) = (i + j) / 2.0;
+    i = j + 1;
+  }
+
+  ranks -= arma::mean(ranks);
+  double ranks_norm = arma::norm(ranks);
+  if (ranks_norm > 0)
+    ranks /= ranks_norm;
+  else
+    ranks.zeros();
+  return ranks;
+}
+
+// Correlations of the subsample from the ranks of its rows (Spearman correlations mapped to the Pearson
+// scale under normality, 2 * sin(pi * rho / 6))
+// - Rank correlations are robust and need no iterations, so they are cheap enough to compute per fit
+// - correlation_predictors holds the columns for the n_models predictors most correlated with the response,
+//   in decreasing order (p x n_models), as the fits on row views expect
+// - Each column is ranked twice (once for the correlations with the response and once for the correlations
+//   with the first predictors), so the ranks of the rows of x are never stored
+void Subsample_Correlations(Row_View& x_rows, arma::vec& y_rows, arma::uword n_models,
+                            arma::mat& correlation_predictors, arma::vec& correlation_response) {
+
+  arma::uword p = x_rows.n_cols;
+  const double pi = 3.14159265358979323846;
+  arma::vec y_ranks = Standardized_Ranks(y_rows);
+  arma::vec column(x_rows.n_rows);
+
+  // Correlations with the response
+  correlation_response.set_size(p);
+  for (arma::uword pred_id = 0; pred_id < p; pred_id++) {
+    const double* x_column = x_rows.x.colptr(pred_id);
+    for (arma::uword i = 0; i < x_rows.n_rows; i++)
+      column(i) = x_column[x_rows.rows(i)];
+    correlation_response(pred_id) = 2 * std::sin(pi / 6 * arma::dot(Standardized_Ranks(column), y_ranks));
+  }
+
+  // Ranks of the predictors most correlated with the response
+  arma::uvec correlation_index = arma::sort_index(arma::abs(correlation_response), "descend");
+  arma::mat first_ranks(x_rows.n_rows, n_models);
+  for (arma::uword m = 0; m < n_models; m++) {
+    const double* x_column = x_rows.x.colptr(correlation_index(m));
+    for (arma::uword i = 0; i < x_rows.n_rows; i++)
+      column(i) = x_column[x_rows.rows(i)];
+    first_ranks.col(m) = Standardized_Ranks(column);
+  }
+
+  // Correlations with the predictors most correlated with the response
+  correlation_predictors.set_size(p, n_models);
+  for (arma::uword pred_id = 0; pred_id < p; pred_id++) {
+    const double* x_column = x_rows.x.colptr(pred_id);
+    for (arma::uword i = 0; i < x_rows.n_rows; i++)
+      column(i) = x_column[x_rows.rows(i)];
+    arma::rowvec rho = Standardized_Ranks(column).t() * first_ranks;
+    correlation_predictors.row(pred_id) = 2 * arma::sin(pi / 6 * rho);
+  }
+}
+
+// Model of the reference fit matched to each model of a fit
+// - reference_model: model of each predictor in the reference fit (n_models if it is in no model)
+// - Pairs of models are matched greedily by the number of shared predictors (ties in order of the models),
+//   so a model is credited to the reference model it reproduces whatever its slot in the fit
+arma::uvec Match_Models(std::vector<std::vector<arma::uword>>& final_predictors,
+                        arma::uvec& reference_model, arma::uword n_models) {
+
+  // Shared predictors of each pair of models
+  arma::umat overlap = arma::zeros<arma::umat>(n_models, n_models);
+  for (arma::uword m = 0; m < n_models; m++)
+    for (arma::uword pred_id = 0; pred_id < final_predictors[m].size(); pred_id++)
+      if (reference_model(final_predictors[m][pred_id]) < n_models)
+        overlap(m, reference_model(final_predictors[m][pred_id]))++;
+
+  // Pairs (m, r), stored as m * n_models + r, in decreasing order of overlap
+  std::vector<arma::uword> pairs(n_models * n_models);
+  for (arma::uword pair = 0; pair < pairs.size(); pair++)
+    pairs[pair] = pair;
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [&](arma::uword a, arma::uword b) {
+                     return overlap(a / n_models, a % n_models) > overlap(b / n_models, b % n_models);
+                   });
+
+  // Greedy matching
+  arma::uvec match(n_models);
+  match.fill(n_models);
+  std::vector<bool> reference_used(n_models, false);
+  for (arma::uword pair = 0; pair < pairs.size(); pair++) {
+    arma::uword m = pairs[pair] / n_models, r = pairs[pair] % n_models;
+    if ((match(m) == n_models) && !reference_used[r]) {
+      match(m) = r;
+      reference_used[r] = true;
+    }
+  }
+
+  return match;
+}
+
+// Stability selection with the robust stepwise split over B subsamples (or bootstrap samples) of the rows
+// - The fits run concurrently over row views of x (no copy of x per fit), and at most n_threads fits are
+//   in memory at once, so the memory does not grow with B
+// - Selection counts are aggregated as each fit completes; the predictors of the fits are not kept
+// - Every split (the fits and the reference split) uses the rank correlations of Subsample_Correlations on
+//   its own rows, so the frequencies describe the split with that estimator (not with the correlations
+//   supplied to Robust_Stepwise_Split), and the first predictors vary with the subsample as the rest of the
+//   models do
+// - The models of each fit are matched to the models of the reference split on all the rows by their shared
+//   predictors, and counted in the slot of the matched model
+// - selection_frequency: proportion of the fits in which each predictor is in some model
+// - model_frequency: proportion of the fits in which each predictor is in the model matched to model m of
+//   the reference split (p x n_models)
+// - model_size: average size of the models matched to each model of the reference split
+// - reference: predictors of the models of the reference split
+// [[Rcpp::export]]
+Rcpp::List Robust_Stepwise_Split_Stability(arma::mat& x, arma::vec& y,
+                                           arma::uword& model_saturation,
+                                           double& sig_level,
+                                           arma::uword& model_size,
+                                           arma::uword& n_models,
+                                           arma::uword B,
+                                           double subsample_fraction = 0.5,
+                                           bool bootstrap = false,
+                                           arma::uword seed = 0,
+                                           arma::uword n_threads = 1){
+
+  arma::uword n = x.n_rows;
+  arma::uword p = x.n_cols;
+  arma::uword subsample_size = std::min(n, std::max<arma::uword>(n_models + 2, std::floor(subsample_fraction * n)));
+
+  // Number of threads
+#ifdef _OPENMP
+  if (n_threads == 0)
+    n_threads = omp_get_num_procs();
+#endif
+
+  // Reference split on all the rows (with the estimator of the fits)
+  arma::uvec all_rows = arma::regspace<arma::uvec>(0, n - 1);
+  Row_View x_all(x, all_rows);
+  arma::mat correlation_predictors;
+  arma::vec correlation_response;
+  Subsample_Correlations(x_all, y, n_models, correlation_predictors, correlation_response);
+  std::vector<std::vector<arma::uword>> reference_predictors = Split_Models(x_all, y,
+                                                                            correlation_predictors, correlation_response,
+                                                                            model_saturation,
+                                                                            sig_level,
+                                                                            model_size,
+                                                                            n_models,
+                                                                            n_threads);
+  arma::uvec reference_model(p);
+  reference_model.fill(n_models);
+  for (arma::uword m = 0; m < n_models; m++)
+    for (arma::uword pred_id = 0; pred_id < reference_predictors[m].size(); pred_id++)
+      reference_model(reference_predictors[m][pred_id]) = m;
+
+  // Selection counts (updated atomically by the fits)
+  arma::uvec selection_count = arma::zeros<arma::uvec>(p);
+  arma::umat model_count = arma::zeros<arma::umat>(p, n_models);
+  arma::uvec model_size_count = arma::zeros<arma::uvec>(n_models);
+  arma::uword* selection_data = selection_count.memptr();
+  arma::uword* model_data = model_count.memptr();
+  arma::uword* model_size_data = model_size_count.memptr();
+
+  std::exception_ptr fit_exception = nullptr;
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+  for (arma::uword b = 0; b < B; b++) {
+    try {
+      // Rows and response of the subsample
+      arma::uvec rows = Subsample_Rows(n, subsample_size, bootstrap, seed, b);
+      arma::vec y_rows = y.elem(rows);
+      Row_View x_rows(x, rows);
+
+      // Correlations of the subsample
+      arma::mat correlation_predictors_rows;
+      arma::vec correlation_response_rows;
+      Subsample_Correlations(x_rows, y_rows, n_models, correlation_predictors_rows, correlation_response_rows);
+
+      // Split the predictors on the subsample
+      std::vector<std::vector<arma::uword>> final_predictors = Split_Models(x_rows, y_rows,
+                                                                            correlation_predictors_rows, correlation_response_rows,
+                                                                            model_saturation,
+                                                                            sig_level,
+                                                                            model_size,
+                                                                            n_models);
+
+      // Aggregate the selections of the fit in the slots of the matched models (a predictor is in at most one model)
+      arma::uvec match = Match_Models(final_predictors, reference_model, n_models);
+      for (arma::uword m = 0; m < n_models; m++) {
+        for (arma::uword pred_id = 0; pred_id < final_predictors[m].size(); pred_id++) {
+          arma::uword predictor = final_predictors[m][pred_id];
+#pragma omp atomic
+          selection_data[predictor]++;
+#pragma omp atomic
+          model_data[match(m) * p + predictor]++;
+        }
+#pragma omp atomic
+        model_size_data[match(m)] += final_predictors[m].size();
+      }
+    } catch (...) {
+#pragma omp critical
+      {
+        if (!fit_exception)
+          fit_exception = std::current_exception();
+      }
+    }
+  }
+
+  // Exceptions of the fits are raised on the calling thread (they cannot leave the parallel region)
+  if (fit_exception)
+    std::rethrow_exception(fit_exception);
+
+  // Selection frequencies over the fits
+  arma::vec selection_frequency = arma::conv_to<arma::vec>::from(selection_count) / B;
+  arma::mat model_frequency = arma::conv_to<arma::mat>::from(model_count) / B;
+  arma::vec model_size_average = arma::conv_to<arma::vec>::from(model_size_count) / B;
+
+  // Models of the reference split
+  Rcpp::List reference(n_models);
+  for (arma::uword m = 0; m < n_models; m++)
+    reference[m] = reference_predictors[m];
+
+  return Rcpp::List::create(Rcpp::Named("selection_frequency") = selection_frequency,
+                            Rcpp::Named("model_frequency") = model_frequency,
+                            Rcpp::Named("model_size") = model_size_average,
+                            Rcpp::Named("reference") = reference);
+}